@@ -0,0 +1,196 @@
+#include "test_server.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/x509.h>
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+namespace {
+
+// Ключ P-256 и сертификат на сутки для CN=127.0.0.1
+void use_self_signed_certificate(ssl::context& ctx) {
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> key_ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr),
+        EVP_PKEY_CTX_free);
+    EVP_PKEY* raw_key = nullptr;
+    if (!key_ctx || EVP_PKEY_keygen_init(key_ctx.get()) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx.get(), NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_keygen(key_ctx.get(), &raw_key) <= 0) {
+        throw std::runtime_error("Failed to generate a TLS key");
+    }
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw_key, EVP_PKEY_free);
+
+    std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+    if (!cert) {
+        throw std::runtime_error("Failed to allocate a certificate");
+    }
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 24 * 60 * 60);
+    X509_set_pubkey(cert.get(), key.get());
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+    if (X509_sign(cert.get(), key.get(), EVP_sha256()) <= 0) {
+        throw std::runtime_error("Failed to sign the certificate");
+    }
+
+    if (SSL_CTX_use_certificate(ctx.native_handle(), cert.get()) != 1 ||
+        SSL_CTX_use_PrivateKey(ctx.native_handle(), key.get()) != 1) {
+        throw std::runtime_error("Failed to install the certificate");
+    }
+}
+
+} // namespace
+
+TestServer::TestServer(const WebGraph& graph, bool https, int threads)
+    : graph_(graph), https_(https), ssl_ctx_(ssl::context::tls_server),
+    acceptor_(ioc_, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0)) {
+    if (https_) {
+        use_self_signed_certificate(ssl_ctx_);
+    }
+    net::co_spawn(ioc_, accept_loop(), net::detached);
+    for (int i = 0; i < std::max(1, threads); ++i) {
+        threads_.emplace_back([this]() {
+            try {
+                ioc_.run();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Exception in test server thread: " << e.what() << std::endl;
+            }
+            });
+    }
+}
+
+TestServer::~TestServer() {
+    stop();
+}
+
+std::string TestServer::base_url() const {
+    return std::string(https_ ? "https" : "http") + "://127.0.0.1:" + std::to_string(acceptor_.local_endpoint().port());
+}
+
+TestServer::Stats TestServer::stats() const {
+    Stats stats;
+    stats.requests = requests_;
+    stats.errors = errors_;
+    stats.bytes = bytes_;
+    stats.connections = connections_;
+    return stats;
+}
+
+void TestServer::stop() {
+    ioc_.stop();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+net::awaitable<void> TestServer::accept_loop() {
+    while (true) {
+        boost::system::error_code ec;
+        tcp::socket socket = co_await acceptor_.async_accept(net::redirect_error(net::use_awaitable, ec));
+        if (ec) {
+            if (ec == net::error::operation_aborted) {
+                co_return;
+            }
+            continue; // Например, исчерпаны дескрипторы: пробуем снова
+        }
+        connections_++;
+        net::co_spawn(acceptor_.get_executor(), session(std::move(socket)), net::detached);
+    }
+}
+
+net::awaitable<void> TestServer::session(tcp::socket socket) {
+    socket.set_option(tcp::no_delay(true));
+    if (!https_) {
+        beast::tcp_stream stream(std::move(socket));
+        co_await serve(stream);
+        boost::system::error_code ec;
+        stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+        co_return;
+    }
+
+    beast::ssl_stream<beast::tcp_stream> stream(beast::tcp_stream(std::move(socket)), ssl_ctx_);
+    boost::system::error_code ec;
+    co_await stream.async_handshake(ssl::stream_base::server, net::redirect_error(net::use_awaitable, ec));
+    if (ec) {
+        co_return;
+    }
+    co_await serve(stream);
+    co_await stream.async_shutdown(net::redirect_error(net::use_awaitable, ec));
+}
+
+// Отвечает на запросы одного соединения, пока клиент держит его открытым
+template <class Stream>
+net::awaitable<void> TestServer::serve(Stream& stream) {
+    beast::flat_buffer buffer;
+    net::steady_timer timer(co_await net::this_coro::executor);
+    const WebGraphOptions& options = graph_.options();
+    while (true) {
+        boost::system::error_code ec;
+        http::request<http::empty_body> req;
+        co_await http::async_read(stream, buffer, req, net::redirect_error(net::use_awaitable, ec));
+        if (ec) {
+            co_return;
+        }
+        requests_++;
+
+        if (options.latency_ms > 0) {
+            timer.expires_after(std::chrono::milliseconds(options.latency_ms));
+            co_await timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+        }
+
+        http::response<http::string_body> res;
+        res.version(req.version());
+        res.set(http::field::server, "SearchEngineBench");
+        std::size_t page = 0;
+        if (!graph_.find({ req.target().data(), req.target().size() }, page)) {
+            res.result(http::status::not_found);
+            res.set(http::field::content_type, "text/plain");
+            res.body() = "Not found";
+            errors_++;
+        }
+        else if (graph_.is_error(page)) {
+            res.result(http::status::internal_server_error);
+            res.set(http::field::content_type, "text/plain");
+            res.body() = "Internal error";
+            errors_++;
+        }
+        else {
+            res.result(http::status::ok);
+            res.set(http::field::content_type, "text/html; charset=utf-8");
+            res.body().reserve(options.page_bytes + 1024);
+            graph_.render(page, res.body());
+        }
+        bytes_ += res.body().size();
+        res.keep_alive(req.keep_alive());
+        res.prepare_payload();
+
+        co_await http::async_write(stream, res, net::redirect_error(net::use_awaitable, ec));
+        if (ec || !res.keep_alive()) {
+            co_return;
+        }
+    }
+}
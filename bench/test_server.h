@@ -0,0 +1,57 @@
+#ifndef TEST_SERVER_H
+#define TEST_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include "web_graph.h"
+
+// Локальный HTTP/HTTPS-сервер для бенчмарка паука: отдает страницы WebGraph
+// на 127.0.0.1 со свободным портом. Для HTTPS при запуске создается
+// самоподписанный сертификат (паук сертификаты не проверяет).
+class TestServer {
+public:
+    struct Stats {
+        std::size_t requests = 0;
+        std::size_t errors = 0;    // Ответы 404 и 500
+        std::size_t bytes = 0;     // Тела ответов
+        std::size_t connections = 0;
+    };
+
+    TestServer(const WebGraph& graph, bool https, int threads);
+    ~TestServer();
+
+    TestServer(const TestServer&) = delete;
+    TestServer& operator=(const TestServer&) = delete;
+
+    // Например, http://127.0.0.1:40123
+    std::string base_url() const;
+    Stats stats() const;
+    void stop();
+
+private:
+    boost::asio::awaitable<void> accept_loop();
+    boost::asio::awaitable<void> session(boost::asio::ip::tcp::socket socket);
+    template <class Stream>
+    boost::asio::awaitable<void> serve(Stream& stream);
+
+    const WebGraph& graph_;
+    bool https_;
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<std::size_t> requests_{ 0 };
+    std::atomic<std::size_t> errors_{ 0 };
+    std::atomic<std::size_t> bytes_{ 0 };
+    std::atomic<std::size_t> connections_{ 0 };
+};
+
+#endif // TEST_SERVER_H
@@ -0,0 +1,109 @@
+#include "web_graph.h"
+#include <array>
+#include <charconv>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kVocabulary = 4096;
+
+std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Словарь из слогов: слова от 2 до 4 слогов, как в обычном тексте
+const std::vector<std::string>& vocabulary() {
+    static const std::vector<std::string> words = []() {
+        constexpr std::array<const char*, 32> syllables = {
+            "ka", "lo", "mi", "ne", "ra", "su", "ti", "vo", "ba", "de", "fi", "go", "hu", "ja", "ke", "li",
+            "ma", "no", "pe", "qui", "ro", "sa", "te", "un", "ver", "wa", "xe", "yo", "zu", "an", "est", "or",
+        };
+        std::vector<std::string> result;
+        result.reserve(kVocabulary);
+        for (std::size_t i = 0; i < kVocabulary; ++i) {
+            std::uint64_t h = splitmix64(i);
+            std::size_t const count = 2 + h % 3;
+            std::string word;
+            for (std::size_t s = 0; s < count; ++s) {
+                h >>= 5;
+                word += syllables[h % syllables.size()];
+            }
+            result.push_back(std::move(word));
+        }
+        return result;
+    }();
+    return words;
+}
+
+} // namespace
+
+WebGraph::WebGraph(const WebGraphOptions& options) : options_(options) {
+    if (options_.pages == 0) {
+        options_.pages = 1;
+    }
+    vocabulary();
+}
+
+bool WebGraph::find(std::string_view target, std::size_t& page) const {
+    constexpr std::string_view prefix = "/page/";
+    if (!target.starts_with(prefix)) {
+        return false;
+    }
+    target.remove_prefix(prefix.size());
+    auto const [end, ec] = std::from_chars(target.data(), target.data() + target.size(), page);
+    return ec == std::errc{} && end == target.data() + target.size() && page < options_.pages;
+}
+
+bool WebGraph::is_error(std::size_t page) const {
+    if (page == 0 || options_.error_rate <= 0) {
+        return false;
+    }
+    std::uint64_t const h = splitmix64(options_.seed ^ (page * 0xD1B54A32D192ED03ULL));
+    return static_cast<double>(h >> 11) / static_cast<double>(1ULL << 53) < options_.error_rate;
+}
+
+void WebGraph::render(std::size_t page, std::string& out) const {
+    const std::vector<std::string>& words = vocabulary();
+    std::size_t const start = out.size();
+    out += "<!DOCTYPE html><html><head><title>Page ";
+    out += std::to_string(page);
+    out += "</title></head><body><h1>Page ";
+    out += std::to_string(page);
+    out += "</h1><ul>";
+
+    std::uint64_t state = splitmix64(options_.seed + page);
+    for (std::size_t i = 0; i < options_.fanout; ++i) {
+        std::size_t const target = i == 0 ? (page + 1) % options_.pages
+            : static_cast<std::size_t>((state = splitmix64(state)) % options_.pages);
+        // Относительные ссылки: паук разрешает их так же, как на настоящих сайтах
+        out += "<li><a href=\"";
+        out += i % 2 == 0 ? "/page/" : "../page/";
+        out += std::to_string(target);
+        out += "\">link</a></li>";
+    }
+    out += "</ul><p>";
+
+    // Частоты слов неравномерны: произведение двух равномерных индексов смещено к началу
+    // словаря. Словарь для каждой страницы перемешан по-своему, иначе у всех страниц были
+    // бы одни и те же частые слова и поиск почти-дубликатов склеил бы их.
+    std::uint64_t const topic = splitmix64(state ^ options_.seed);
+    std::size_t const multiplier = (topic & (kVocabulary - 1)) | 1;
+    std::size_t const offset = (topic >> 12) & (kVocabulary - 1);
+    std::size_t words_in_paragraph = 0;
+    while (out.size() - start < options_.page_bytes) {
+        state = splitmix64(state);
+        std::size_t const a = state & (kVocabulary - 1);
+        std::size_t const b = (state >> 12) & (kVocabulary - 1);
+        std::size_t const rank = a * b / kVocabulary;
+        out += words[(rank * multiplier + offset) & (kVocabulary - 1)];
+        out += ' ';
+        if (++words_in_paragraph == 80) {
+            out += "</p><p>";
+            words_in_paragraph = 0;
+        }
+    }
+    out += "</p></body></html>";
+}
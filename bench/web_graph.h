@@ -0,0 +1,40 @@
+#ifndef WEB_GRAPH_H
+#define WEB_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Параметры синтетического сайта
+struct WebGraphOptions {
+    std::size_t pages = 10000;
+    std::size_t fanout = 10;          // Ссылок на странице
+    std::size_t page_bytes = 16384;   // Примерный размер страницы
+    int latency_ms = 0;               // Задержка перед ответом
+    double error_rate = 0;            // Доля страниц, отвечающих 500
+    std::uint64_t seed = 1;
+};
+
+// Детерминированный граф страниц /page/0 ... /page/N-1. Страницы не хранятся,
+// а генерируются по номеру: у каждой свой текст (иначе их отбросит поиск
+// дубликатов) и fanout ссылок, первая из которых ведет на следующую страницу,
+// поэтому с /page/0 достижим весь граф.
+class WebGraph {
+public:
+    explicit WebGraph(const WebGraphOptions& options);
+
+    const WebGraphOptions& options() const { return options_; }
+
+    // Номер страницы по пути запроса; false, если такой страницы нет
+    bool find(std::string_view target, std::size_t& page) const;
+    bool is_error(std::size_t page) const;
+
+    // HTML страницы дописывается в out
+    void render(std::size_t page, std::string& out) const;
+
+private:
+    WebGraphOptions options_;
+};
+
+#endif // WEB_GRAPH_H
@@ -14,7 +14,39 @@ Config read_config(const std::string& filename) {
     config.db_password = pt.get<std::string>("database.password");
     config.start_url = pt.get<std::string>("spider.start_url");
     config.recursion_depth = pt.get<int>("spider.recursion_depth");
+    config.thread_count = pt.get<int>("spider.thread_count", config.thread_count);
+    config.index_threads = pt.get<int>("spider.index_threads", config.index_threads);
+    config.parse_queue_size = pt.get<int>("spider.parse_queue_size", config.parse_queue_size);
+    config.index_queue_size = pt.get<int>("spider.index_queue_size", config.index_queue_size);
+    config.stats_interval_seconds = pt.get<int>("spider.stats_interval_seconds", config.stats_interval_seconds);
+    config.io_thread_count = pt.get<int>("spider.io_thread_count", config.io_thread_count);
+    config.max_concurrent_fetches = pt.get<int>("spider.max_concurrent_fetches", config.max_concurrent_fetches);
+    config.request_timeout_seconds = pt.get<int>("spider.request_timeout_seconds", config.request_timeout_seconds);
+    config.max_idle_connections_per_host = pt.get<int>("spider.max_idle_connections_per_host", config.max_idle_connections_per_host);
+    config.max_idle_connections = pt.get<int>("spider.max_idle_connections", config.max_idle_connections);
+    config.keep_alive_seconds = pt.get<int>("spider.keep_alive_seconds", config.keep_alive_seconds);
+    config.dns_cache_ttl_seconds = pt.get<int>("spider.dns_cache_ttl_seconds", config.dns_cache_ttl_seconds);
+    config.frontier_partitions = pt.get<int>("spider.frontier_partitions", config.frontier_partitions);
+    config.frontier_dir = pt.get<std::string>("spider.frontier_dir", config.frontier_dir);
+    config.frontier_memory_megabytes = pt.get<int>("spider.frontier_memory_megabytes", config.frontier_memory_megabytes);
+    config.checkpoint_interval_seconds = pt.get<int>("spider.checkpoint_interval_seconds", config.checkpoint_interval_seconds);
+    config.politeness_delay_ms = pt.get<int>("spider.politeness_delay_ms", config.politeness_delay_ms);
+    config.max_body_bytes = pt.get<long long>("spider.max_body_bytes", config.max_body_bytes);
+    config.visited_max_entries = pt.get<long long>("spider.visited_max_entries", config.visited_max_entries);
+    config.visited_bloom_megabytes = pt.get<int>("spider.visited_bloom_megabytes", config.visited_bloom_megabytes);
+    config.document_store = pt.get<std::string>("spider.document_store", config.document_store);
+    config.zstd_level = pt.get<int>("spider.zstd_level", config.zstd_level);
+    config.incremental = pt.get<bool>("spider.incremental", config.incremental);
+    config.default_charset = pt.get<std::string>("spider.default_charset", config.default_charset);
+    config.near_duplicate_distance = pt.get<int>("spider.near_duplicate_distance", config.near_duplicate_distance);
+    config.index_batch_pages = pt.get<int>("spider.index_batch_pages", config.index_batch_pages);
+    config.db_pool_size = pt.get<int>("database.pool_size", config.db_pool_size);
+    config.term_cache_megabytes = pt.get<int>("database.term_cache_megabytes", config.term_cache_megabytes);
     config.server_port = pt.get<int>("search_server.port");
+    config.server_threads = pt.get<int>("search_server.threads", config.server_threads);
+    config.bm25_k1 = pt.get<double>("search_server.bm25_k1", config.bm25_k1);
+    config.bm25_b = pt.get<double>("search_server.bm25_b", config.bm25_b);
+    config.search_results = pt.get<int>("search_server.results", config.search_results);
 
     return config;
 }
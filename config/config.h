@@ -12,7 +12,38 @@ struct Config {
     std::string start_url;
     int recursion_depth;
     int server_port;
-    int thread_count = 4;
+    int server_threads = 0;             // 0 - по числу ядер
+    int db_pool_size = 8;
+    int thread_count = 0;               // Потоки разбора, 0 - по числу ядер
+    int index_threads = 2;
+    int parse_queue_size = 256;
+    int index_queue_size = 256;
+    int stats_interval_seconds = 10;
+    int io_thread_count = 2;
+    int max_concurrent_fetches = 256;
+    int request_timeout_seconds = 30;
+    int max_idle_connections_per_host = 8;
+    int max_idle_connections = 256;     // На все хосты вместе
+    int keep_alive_seconds = 30;
+    int dns_cache_ttl_seconds = 300;
+    int frontier_partitions = 16;
+    std::string frontier_dir;           // Пусто - граница только в памяти
+    int frontier_memory_megabytes = 256;
+    int checkpoint_interval_seconds = 300;
+    int politeness_delay_ms = 0;
+    long long max_body_bytes = 8 * 1024 * 1024; // После распаковки
+    long long visited_max_entries = 0;  // 0 - без ограничения
+    int visited_bloom_megabytes = 0;    // 0 - без фильтра Блума
+    int index_batch_pages = 64;
+    std::string document_store = "raw"; // raw, text или zstd
+    int zstd_level = 3;
+    bool incremental = false;           // Повторный обход с условным GET по сохраненным страницам
+    std::string default_charset = "windows-1251"; // Для страниц без объявленной кодировки, если они не в UTF-8
+    int near_duplicate_distance = 3;    // Меньше 0 - без поиска дубликатов
+    int term_cache_megabytes = 256;
+    double bm25_k1 = 1.2;               // Насыщение частоты слова
+    double bm25_b = 0.75;               // Вес нормировки по длине документа
+    int search_results = 20;            // Сколько лучших документов показывать
 };
 
 Config read_config(const std::string& filename);
@@ -0,0 +1,26 @@
+#include "crawl_state.h"
+#include <optional>
+#include <string_view>
+
+std::size_t CrawlState::load(pqxx::connection& conn, int unknown_depth) {
+    pqxx::work txn(conn);
+    auto stream = pqxx::stream_from::query(txn,
+        "SELECT url, etag, last_modified, content_hash, depth FROM search_engine.documents");
+    for (auto [url, etag, last_modified, content_hash, depth] : stream.iter<std::string_view,
+        std::optional<std::string_view>, std::optional<std::string_view>, std::optional<long long>, std::optional<int>>()) {
+        Page page;
+        page.etag = etag.value_or("");
+        page.last_modified = last_modified.value_or("");
+        page.content_hash = static_cast<std::uint64_t>(content_hash.value_or(0));
+        page.depth = depth.value_or(unknown_depth);
+        pages_.insert_or_assign(std::string(url), std::move(page));
+    }
+    stream.complete();
+    txn.commit();
+    return pages_.size();
+}
+
+const CrawlState::Page* CrawlState::find(const std::string& url) const {
+    auto it = pages_.find(url);
+    return it == pages_.end() ? nullptr : &it->second;
+}
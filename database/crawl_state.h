@@ -0,0 +1,40 @@
+#ifndef CRAWL_STATE_H
+#define CRAWL_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <pqxx/pqxx>
+
+// Что известно о ранее сохраненных страницах: валидаторы HTTP для условного
+// GET, отпечаток содержимого и глубина. Загружается один раз перед
+// инкрементальным обходом, во время обхода только читается.
+class CrawlState {
+public:
+    struct Page {
+        std::string etag;
+        std::string last_modified;
+        std::uint64_t content_hash = 0;
+        int depth = 0;
+    };
+
+    // Загружает search_engine.documents; возвращает число страниц. Строкам,
+    // записанным до появления столбца depth, дается unknown_depth
+    std::size_t load(pqxx::connection& conn, int unknown_depth);
+
+    const Page* find(const std::string& url) const;
+    std::size_t size() const { return pages_.size(); }
+
+    template <class F>
+    void for_each(F&& f) const {
+        for (const auto& [url, page] : pages_) {
+            f(url, page);
+        }
+    }
+
+private:
+    std::unordered_map<std::string, Page> pages_;
+};
+
+#endif // CRAWL_STATE_H
@@ -1,41 +1,47 @@
 #include "database.h"
+#include <chrono>
 #include <iostream>
 
 Database::Database(const Config& config)
-    : conn_("host=" + config.db_host +
-        " port=" + std::to_string(config.db_port) +
-        " dbname=" + config.db_name +
-        " user=" + config.db_user +
-        " password=" + config.db_password) {
+    : pool_(config),
+    terms_(static_cast<std::size_t>(config.term_cache_megabytes) * 1024 * 1024) {
 }
 
-void Database::save_document(const std::string& url, const std::string& content, pqxx::work& txn) {
-    txn.exec_params("INSERT INTO search_engine.documents (url, content) VALUES ($1, $2) ON CONFLICT (url) DO NOTHING", url, content);
+DatabasePool::Lease Database::connection() {
+    return pool_.acquire();
 }
 
-void Database::save_word_frequency(int document_id, const std::string& word, int frequency, pqxx::work& txn) {
-    pqxx::result r = txn.exec_params("SELECT id FROM search_engine.words WHERE word = $1", word);
-    int word_id;
-    if (r.empty()) {
-        r = txn.exec_params("INSERT INTO search_engine.words (word) VALUES ($1) RETURNING id", word);
-        word_id = r[0][0].as<int>();
-    }
-    else {
-        word_id = r[0][0].as<int>();
-    }
-    txn.exec_params("INSERT INTO search_engine.word_frequencies (document_id, word_id, frequency) VALUES ($1, $2, $3) ON CONFLICT (document_id, word_id) DO NOTHING", document_id, word_id, frequency);
+DatabasePool& Database::pool() {
+    return pool_;
 }
 
-pqxx::connection& Database::conn() {
-    return conn_;
+TermDictionary& Database::terms() {
+    return terms_;
 }
 
-//   create_tables
+void Database::warm_terms() {
+    try {
+        auto const started = std::chrono::steady_clock::now();
+        std::size_t const loaded = terms_.warm(*pool_.acquire());
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        auto const stats = terms_.stats();
+        std::cout << "Term dictionary: " << loaded << " words loaded in " << seconds << " s, "
+            << stats.bytes / (1024 * 1024) << " of " << stats.max_bytes / (1024 * 1024) << " MiB" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception in warm_terms: " << e.what() << std::endl;
+    }
+}
+
+// Реализация метода create_tables
 void Database::create_tables() {
     try {
-        //  
+        // search_path задается для сессии, поэтому все шаги идут через одно соединение
+        DatabasePool::Lease conn = pool_.acquire();
+
+        // Создание схемы
         {
-            pqxx::work txn(conn_);
+            pqxx::work txn(*conn);
             std::string create_schema_query = "CREATE SCHEMA IF NOT EXISTS search_engine;";
             std::cout << "Creating schema: " << create_schema_query << std::endl;
             txn.exec(create_schema_query);
@@ -43,25 +49,32 @@ void Database::create_tables() {
             txn.commit();
         }
 
-        //  search_path  search_engine
+        // Устанавливаем search_path на search_engine
         {
-            pqxx::work txn_set_schema(conn_);
+            pqxx::work txn_set_schema(*conn);
             txn_set_schema.exec("SET search_path TO search_engine");
             txn_set_schema.commit();
         }
 
-        //     search_engine
+        // Создание таблиц в схеме search_engine
         {
-            pqxx::work txn(conn_);
+            pqxx::work txn(*conn);
             std::string query1 = "CREATE TABLE IF NOT EXISTS documents (id SERIAL PRIMARY KEY, url TEXT UNIQUE, content TEXT);";
             std::cout << "Executing query1: " << query1 << std::endl;
             txn.exec(query1);
+            // Сжатый HTML для document_store=zstd
+            txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS content_zstd BYTEA;");
+            // Состояние для инкрементального обхода: валидаторы HTTP, отпечаток содержимого и глубина
+            txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS etag TEXT, ADD COLUMN IF NOT EXISTS last_modified TEXT, "
+                "ADD COLUMN IF NOT EXISTS content_hash BIGINT, ADD COLUMN IF NOT EXISTS depth INT;");
+            // Число слов страницы для нормировки BM25
+            txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS length INT;");
             std::cout << "Table documents created." << std::endl;
             txn.commit();
         }
 
         {
-            pqxx::work txn(conn_);
+            pqxx::work txn(*conn);
             std::string query2 = "CREATE TABLE IF NOT EXISTS words (id SERIAL PRIMARY KEY, word TEXT UNIQUE);";
             std::cout << "Executing query2: " << query2 << std::endl;
             txn.exec(query2);
@@ -70,14 +83,26 @@ void Database::create_tables() {
         }
 
         {
-            pqxx::work txn(conn_);
+            pqxx::work txn(*conn);
             std::string query3 = "CREATE TABLE IF NOT EXISTS word_frequencies (document_id INT REFERENCES documents(id), word_id INT REFERENCES words(id), frequency INT, PRIMARY KEY (document_id, word_id));";
             std::cout << "Executing query3: " << query3 << std::endl;
             txn.exec(query3);
+            // Позиции слова на странице для фраз и близости слов
+            txn.exec("ALTER TABLE word_frequencies ADD COLUMN IF NOT EXISTS positions BYTEA;");
             std::cout << "Table word_frequencies created." << std::endl;
             txn.commit();
         }
 
+        {
+            // Дубликаты страниц: вместо содержимого и частот хранится ссылка на оригинал
+            pqxx::work txn(*conn);
+            std::string query4 = "CREATE TABLE IF NOT EXISTS document_aliases (url TEXT PRIMARY KEY, canonical_url TEXT NOT NULL);";
+            std::cout << "Executing query4: " << query4 << std::endl;
+            txn.exec(query4);
+            std::cout << "Table document_aliases created." << std::endl;
+            txn.commit();
+        }
+
         std::cout << "Tables created successfully." << std::endl;
     }
     catch (const pqxx::sql_error& e) {
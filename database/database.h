@@ -3,20 +3,27 @@
 
 #include <pqxx/pqxx>
 #include "../config/config.h"
+#include "database_pool.h"
+#include "term_dictionary.h"
 
 class Database {
 public:
     Database(const Config& config);
 
-    void save_document(const std::string& url, const std::string& content, pqxx::work& txn);
-    void save_word_frequency(int document_id, const std::string& word, int frequency, pqxx::work& txn);
-    pqxx::connection& conn();
+    // Соединение из пула на время жизни возвращенного объекта
+    DatabasePool::Lease connection();
+    DatabasePool& pool();
+    TermDictionary& terms();
 
-    //     
+    // Загружает словарь слов из базы; вызывается после create_tables
+    void warm_terms();
+
+    // Добавляем метод для создания таблиц
     void create_tables();
 
 private:
-    pqxx::connection conn_;
+    DatabasePool pool_;
+    TermDictionary terms_;
 };
 
 #endif // DATABASE_H
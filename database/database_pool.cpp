@@ -0,0 +1,113 @@
+#include "database_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Соединение, простоявшее дольше этого времени, проверяется запросом перед выдачей
+constexpr std::chrono::seconds kCheckAfter{ 30 };
+
+} // namespace
+
+DatabasePool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)), slot_(std::move(other.slot_)) {
+}
+
+DatabasePool::Lease::~Lease() {
+    if (pool_) {
+        pool_->release(std::move(slot_));
+    }
+}
+
+DatabasePool::DatabasePool(const Config& config)
+    : options_(connection_options(config)),
+    size_(static_cast<std::size_t>(std::max(1, config.db_pool_size))) {
+}
+
+std::string DatabasePool::connection_options(const Config& config) {
+    return "host=" + config.db_host +
+        " port=" + std::to_string(config.db_port) +
+        " dbname=" + config.db_name +
+        " user=" + config.db_user +
+        " password=" + config.db_password;
+}
+
+DatabasePool::Slot DatabasePool::connect() {
+    Slot slot;
+    slot.conn = std::make_unique<pqxx::connection>(options_);
+    slot.session = ++next_session_;
+    return slot;
+}
+
+bool DatabasePool::healthy(Slot& slot) const {
+    if (!slot.conn->is_open()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() - slot.idle_since < kCheckAfter) {
+        return true;
+    }
+    try {
+        pqxx::nontransaction txn(*slot.conn);
+        txn.exec("SELECT 1");
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+DatabasePool::Lease DatabasePool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (idle_.empty() && open_ >= size_) {
+        stats_.waits++;
+        cv_.wait(lock, [this]() { return !idle_.empty() || open_ < size_; });
+    }
+    stats_.acquired++;
+
+    bool const reuse = !idle_.empty();
+    Slot slot;
+    if (reuse) {
+        slot = std::move(idle_.back());
+        idle_.pop_back();
+    }
+    else {
+        open_++;
+    }
+    lock.unlock();
+
+    try {
+        if (reuse && healthy(slot)) {
+            return Lease(this, std::move(slot));
+        }
+        if (reuse) {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stats_.reconnects++;
+        }
+        return Lease(this, connect());
+    }
+    catch (...) {
+        // Место в пуле освобождается, чтобы следующий вызов попробовал подключиться заново
+        std::lock_guard<std::mutex> guard(mutex_);
+        open_--;
+        cv_.notify_one();
+        throw;
+    }
+}
+
+void DatabasePool::release(Slot slot) {
+    bool const open = slot.conn && slot.conn->is_open();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open) {
+        slot.idle_since = std::chrono::steady_clock::now();
+        idle_.push_back(std::move(slot));
+    }
+    else {
+        open_--;
+    }
+    cv_.notify_one();
+}
+
+DatabasePool::Stats DatabasePool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,76 @@
+#ifndef DATABASE_POOL_H
+#define DATABASE_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+#include "../config/config.h"
+
+// Пул соединений с PostgreSQL. Соединения создаются по мере надобности,
+// но не больше size; при нехватке acquire() ждет возврата соединения.
+class DatabasePool {
+    struct Slot {
+        std::unique_ptr<pqxx::connection> conn;
+        std::uint64_t session = 0; // Номер физического соединения, меняется при переподключении
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+public:
+    // Соединение, взятое из пула; возвращается в пул в деструкторе
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *slot_.conn; }
+        pqxx::connection* operator->() const { return slot_.conn.get(); }
+        std::uint64_t session() const { return slot_.session; }
+
+    private:
+        friend class DatabasePool;
+        Lease(DatabasePool* pool, Slot slot) : pool_(pool), slot_(std::move(slot)) {}
+
+        DatabasePool* pool_;
+        Slot slot_;
+    };
+
+    struct Stats {
+        std::size_t acquired = 0;
+        std::size_t waits = 0;
+        std::size_t reconnects = 0;
+    };
+
+    explicit DatabasePool(const Config& config);
+
+    // Строка подключения из настроек, для соединений вне пула
+    static std::string connection_options(const Config& config);
+
+    Lease acquire();
+    std::size_t size() const { return size_; }
+    Stats stats() const;
+
+private:
+    Slot connect();
+    bool healthy(Slot& slot) const;
+    void release(Slot slot);
+
+    std::string options_;
+    std::size_t size_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Slot> idle_;
+    std::size_t open_ = 0; // Выданные и свободные соединения
+    std::atomic<std::uint64_t> next_session_{ 0 };
+    Stats stats_;
+};
+
+#endif // DATABASE_POOL_H
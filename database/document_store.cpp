@@ -0,0 +1,121 @@
+#include "document_store.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#ifdef SEARCH_ENGINE_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+DocumentStoreMode parse_mode(const std::string& name) {
+    if (name == "text") {
+        return DocumentStoreMode::Text;
+    }
+    if (name == "zstd") {
+#ifdef SEARCH_ENGINE_WITH_ZSTD
+        return DocumentStoreMode::Zstd;
+#else
+        std::cerr << "Built without zstd, document_store=zstd falls back to text" << std::endl;
+        return DocumentStoreMode::Text;
+#endif
+    }
+    if (name != "raw") {
+        std::cerr << "Unknown document_store mode '" << name << "', storing raw HTML" << std::endl;
+    }
+    return DocumentStoreMode::Raw;
+}
+
+// Текст после сканера полон пробелов на месте тегов; серии пробелов сжимаются в один
+void compact_whitespace(std::string_view text, std::string& out) {
+    out.clear();
+    out.reserve(text.size());
+    bool space = true;
+    for (char c : text) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f') {
+            if (!space) {
+                out += ' ';
+                space = true;
+            }
+        }
+        else {
+            out += c;
+            space = false;
+        }
+    }
+    if (!out.empty() && out.back() == ' ') {
+        out.pop_back();
+    }
+}
+
+#ifdef SEARCH_ENGINE_WITH_ZSTD
+struct CompressionContextDeleter {
+    void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+};
+
+// Контекст сжатия на поток: его буферы переиспользуются между страницами
+ZSTD_CCtx* compression_context() {
+    thread_local std::unique_ptr<ZSTD_CCtx, CompressionContextDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+#endif
+
+} // namespace
+
+DocumentStore::DocumentStore(const Config& config)
+    : mode_(parse_mode(config.document_store)), level_(config.zstd_level) {
+}
+
+const char* DocumentStore::mode_name() const {
+    switch (mode_) {
+    case DocumentStoreMode::Text:
+        return "text";
+    case DocumentStoreMode::Zstd:
+        return "zstd";
+    default:
+        return "raw";
+    }
+}
+
+void DocumentStore::encode(std::string_view html, std::string_view text, std::string& content,
+    [[maybe_unused]] Bytes& compressed) {
+    documents_++;
+    input_bytes_ += html.size();
+
+    switch (mode_) {
+    case DocumentStoreMode::Raw:
+        content.assign(html);
+        stored_bytes_ += content.size();
+        break;
+    case DocumentStoreMode::Text:
+        compact_whitespace(text, content);
+        stored_bytes_ += content.size();
+        break;
+    case DocumentStoreMode::Zstd: {
+#ifdef SEARCH_ENGINE_WITH_ZSTD
+        auto const started = std::chrono::steady_clock::now();
+        compressed.resize(ZSTD_compressBound(html.size()));
+        std::size_t const size = ZSTD_compressCCtx(compression_context(), compressed.data(), compressed.size(),
+            html.data(), html.size(), level_);
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+        }
+        compressed.resize(size);
+        stored_bytes_ += size;
+        compress_nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count();
+#endif
+        break;
+    }
+    }
+}
+
+DocumentStore::Stats DocumentStore::stats() const {
+    Stats stats;
+    stats.documents = documents_;
+    stats.input_bytes = input_bytes_;
+    stats.stored_bytes = stored_bytes_;
+    stats.compress_seconds = compress_nanoseconds_ / 1e9;
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef DOCUMENT_STORE_H
+#define DOCUMENT_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "../config/config.h"
+
+// Что хранится в documents для каждой страницы:
+//   raw  - исходный HTML в content (как раньше);
+//   text - только извлеченный текст в content, HTML не сохраняется;
+//   zstd - HTML, сжатый zstd, в content_zstd (bytea), content пустой.
+enum class DocumentStoreMode { Raw, Text, Zstd };
+
+// Готовит содержимое документа к записи согласно режиму и считает,
+// сколько байт пришло и сколько будет записано
+class DocumentStore {
+public:
+    using Bytes = std::basic_string<std::byte>;
+
+    struct Stats {
+        std::size_t documents = 0;
+        std::size_t input_bytes = 0;
+        std::size_t stored_bytes = 0;
+        double compress_seconds = 0;
+    };
+
+    explicit DocumentStore(const Config& config);
+
+    DocumentStoreMode mode() const { return mode_; }
+    const char* mode_name() const;
+
+    // Заполняет content или compressed для одной страницы
+    void encode(std::string_view html, std::string_view text, std::string& content, Bytes& compressed);
+
+    Stats stats() const;
+
+private:
+    DocumentStoreMode mode_;
+    int level_;
+
+    std::atomic<std::size_t> documents_{ 0 };
+    std::atomic<std::size_t> input_bytes_{ 0 };
+    std::atomic<std::size_t> stored_bytes_{ 0 };
+    std::atomic<long long> compress_nanoseconds_{ 0 };
+};
+
+#endif // DOCUMENT_STORE_H
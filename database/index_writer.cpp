@@ -0,0 +1,336 @@
+#include "index_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+IndexWriter::IndexWriter(Database& db, const Config& config)
+    : db_(db), batch_pages_(static_cast<std::size_t>(std::max(1, config.index_batch_pages))) {
+    batch_.reserve(batch_pages_);
+}
+
+namespace {
+
+// COPY в столбец TEXT отвергает байт NUL, и из-за одной такой страницы
+// откатился бы весь пакет
+void strip_nul(std::string& text) {
+    text.erase(std::remove(text.begin(), text.end(), '\0'), text.end());
+}
+
+} // namespace
+
+void IndexWriter::add(IndexedPage page) {
+    strip_nul(page.url);
+    strip_nul(page.alias_of);
+    strip_nul(page.etag);
+    strip_nul(page.last_modified);
+    strip_nul(page.content);
+    std::vector<IndexedPage> full;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_.push_back(std::move(page));
+        if (batch_.size() < batch_pages_) {
+            return;
+        }
+        full.swap(batch_);
+        batch_.reserve(batch_pages_);
+    }
+    write(full);
+}
+
+void IndexWriter::flush() {
+    std::vector<IndexedPage> rest;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        rest.swap(batch_);
+    }
+    if (!rest.empty()) {
+        write(rest);
+    }
+}
+
+IndexWriter::Stats IndexWriter::stats() const {
+    Stats stats;
+    stats.pages = pages_;
+    stats.postings = postings_;
+    stats.aliases = aliases_;
+    stats.unchanged = unchanged_;
+    stats.stored_bytes = stored_bytes_;
+    stats.write_seconds = write_nanoseconds_ / 1e9;
+    stats.batches = batches_;
+    stats.failed_batches = failed_batches_;
+    stats.failed_pages = failed_pages_;
+    return stats;
+}
+
+// Временные таблицы живут до конца сессии, строки очищаются при каждом COMMIT.
+// Создаются один раз для каждого соединения пула.
+void IndexWriter::prepare_staging(const DatabasePool::Lease& conn) {
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (staged_sessions_.count(conn.session())) {
+            return;
+        }
+    }
+    pqxx::work txn(*conn);
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_documents (url TEXT, content TEXT, content_zstd BYTEA, "
+        "etag TEXT, last_modified TEXT, content_hash BIGINT, depth INT, length INT) ON COMMIT DELETE ROWS");
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_postings (url TEXT, word_id INT, frequency INT, positions BYTEA) "
+        "ON COMMIT DELETE ROWS");
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_words (word TEXT) ON COMMIT DELETE ROWS");
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_new_words (id INT, word TEXT) ON COMMIT DELETE ROWS");
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_aliases (url TEXT, canonical_url TEXT) ON COMMIT DELETE ROWS");
+    txn.exec("CREATE TEMP TABLE IF NOT EXISTS index_staging_validators (url TEXT, etag TEXT, last_modified TEXT) ON COMMIT DELETE ROWS");
+    txn.commit();
+
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    staged_sessions_.insert(conn.session());
+}
+
+// Идентификаторы слов пакета в порядке обхода страниц. Слова, которых нет
+// в словаре, ищутся в базе одним запросом; оставшимся выдаются новые id.
+// В new_terms попадают слова, которые нужно добавить в словарь после COMMIT.
+std::vector<int> IndexWriter::resolve_word_ids(pqxx::work& txn, const std::vector<IndexedPage>& batch,
+    std::unordered_map<std::string_view, int>& new_terms) {
+    TermDictionary& dictionary = db_.terms();
+    std::vector<int> ids;
+    for (const auto& page : batch) {
+        std::string_view const all_words = page.words;
+        std::size_t offset = 0;
+        for (const auto& count : page.counts) {
+            std::string_view const word = all_words.substr(offset, count.length);
+            offset += count.length;
+            std::optional<int> const id = dictionary.find(word);
+            ids.push_back(id ? *id : -1);
+            if (!id) {
+                new_terms.emplace(word, -1);
+            }
+        }
+    }
+    if (new_terms.empty()) {
+        return ids;
+    }
+
+    // Слова, уже записанные другим процессом или не поместившиеся в словарь
+    auto lookup = pqxx::stream_to::table(txn, { "index_staging_words" }, { "word" });
+    for (const auto& [word, id] : new_terms) {
+        lookup.write_values(word);
+    }
+    lookup.complete();
+    pqxx::result known = txn.exec(
+        "SELECT s.word, w.id FROM index_staging_words s JOIN search_engine.words w ON w.word = s.word");
+    for (const auto& row : known) {
+        auto it = new_terms.find(row[0].view());
+        if (it != new_terms.end()) {
+            it->second = row[1].as<int>();
+        }
+    }
+
+    std::size_t const fresh_count = static_cast<std::size_t>(std::count_if(new_terms.begin(), new_terms.end(),
+        [](const auto& term) { return term.second < 0; }));
+    if (fresh_count > 0) {
+        std::vector<int> fresh_ids = dictionary.reserve_ids(txn, fresh_count);
+        auto fresh = pqxx::stream_to::table(txn, { "index_staging_new_words" }, { "id", "word" });
+        for (auto& [word, id] : new_terms) {
+            if (id < 0) {
+                id = fresh_ids.back();
+                fresh_ids.pop_back();
+                fresh.write_values(id, word);
+            }
+        }
+        fresh.complete();
+
+        // Если слово успел вставить параллельный писатель, берем его id
+        pqxx::result inserted = txn.exec(
+            "INSERT INTO search_engine.words (id, word) SELECT id, word FROM index_staging_new_words "
+            "ORDER BY word ON CONFLICT (word) DO NOTHING RETURNING id");
+        if (inserted.size() < fresh_count) {
+            pqxx::result raced = txn.exec(
+                "SELECT s.word, w.id FROM index_staging_new_words s "
+                "JOIN search_engine.words w ON w.word = s.word WHERE w.id <> s.id");
+            for (const auto& row : raced) {
+                auto it = new_terms.find(row[0].view());
+                if (it != new_terms.end()) {
+                    it->second = row[1].as<int>();
+                }
+            }
+        }
+    }
+
+    std::size_t index = 0;
+    for (const auto& page : batch) {
+        std::string_view const all_words = page.words;
+        std::size_t offset = 0;
+        for (const auto& count : page.counts) {
+            if (ids[index] < 0) {
+                ids[index] = new_terms.at(all_words.substr(offset, count.length));
+            }
+            offset += count.length;
+            index++;
+        }
+    }
+    return ids;
+}
+
+// Если пакет не записался, страницы пишутся по одной: теряются только те,
+// что не проходят сами по себе, а не весь пакет. Их URL уже в посещенных,
+// поэтому повторно паук их не загрузит.
+void IndexWriter::write(std::vector<IndexedPage>& batch) {
+    if (write_batch(batch)) {
+        return;
+    }
+    failed_batches_++;
+    if (batch.size() == 1) {
+        failed_pages_++;
+        return;
+    }
+    std::cerr << "Retrying " << batch.size() << " pages one by one" << std::endl;
+    std::vector<IndexedPage> single(1);
+    for (auto& page : batch) {
+        single[0] = std::move(page);
+        if (!write_batch(single)) {
+            failed_pages_++;
+            std::cerr << "Page not indexed: " << single[0].url << std::endl;
+        }
+    }
+}
+
+bool IndexWriter::write_batch(std::vector<IndexedPage>& batch) {
+    auto const started = std::chrono::steady_clock::now();
+    std::size_t postings = 0;
+    std::size_t stored_bytes = 0;
+    std::unordered_map<std::string_view, int> new_terms;
+    try {
+        // Пакеты из разных потоков пишутся параллельно через разные соединения
+        DatabasePool::Lease conn = db_.connection();
+        prepare_staging(conn);
+        pqxx::work txn(*conn);
+
+        std::vector<int> const word_ids = resolve_word_ids(txn, batch, new_terms);
+
+        // Дубликаты записываются только как псевдонимы, без содержимого и частот;
+        // у неизмененных страниц обновляются только валидаторы
+        std::size_t aliases = 0;
+        std::size_t unchanged = 0;
+        auto documents = pqxx::stream_to::table(txn, { "index_staging_documents" },
+            { "url", "content", "content_zstd", "etag", "last_modified", "content_hash", "depth", "length" });
+        for (const auto& page : batch) {
+            auto const content_hash = static_cast<long long>(page.content_hash);
+            if (!page.alias_of.empty()) {
+                aliases++;
+            }
+            else if (page.unchanged) {
+                unchanged++;
+            }
+            else if (!page.content_zstd.empty()) {
+                documents.write_values(page.url, nullptr, page.content_zstd, page.etag, page.last_modified, content_hash,
+                    page.depth, page.length);
+                stored_bytes += page.content_zstd.size();
+            }
+            else {
+                documents.write_values(page.url, page.content, nullptr, page.etag, page.last_modified, content_hash,
+                    page.depth, page.length);
+                stored_bytes += page.content.size();
+            }
+        }
+        documents.complete();
+
+        if (unchanged > 0) {
+            auto validators = pqxx::stream_to::table(txn, { "index_staging_validators" }, { "url", "etag", "last_modified" });
+            for (const auto& page : batch) {
+                if (page.unchanged) {
+                    validators.write_values(page.url, page.etag, page.last_modified);
+                }
+            }
+            validators.complete();
+            txn.exec(
+                "UPDATE search_engine.documents d SET etag = v.etag, last_modified = v.last_modified "
+                "FROM index_staging_validators v WHERE d.url = v.url");
+        }
+
+        if (aliases > 0) {
+            auto alias_stream = pqxx::stream_to::table(txn, { "index_staging_aliases" }, { "url", "canonical_url" });
+            for (const auto& page : batch) {
+                if (!page.alias_of.empty()) {
+                    alias_stream.write_values(page.url, page.alias_of);
+                }
+            }
+            alias_stream.complete();
+            // Страница, которая при прошлом обходе была документом, а теперь
+            // дубликат, теряет строку документа и частоты, иначе находилась бы
+            // поиском дважды. Псевдонимы, указывавшие на нее, переводятся на ее оригинал.
+            txn.exec(
+                "INSERT INTO search_engine.document_aliases (url, canonical_url) "
+                "SELECT DISTINCT ON (url) url, canonical_url FROM index_staging_aliases "
+                "ON CONFLICT (url) DO UPDATE SET canonical_url = EXCLUDED.canonical_url; "
+                "DELETE FROM search_engine.word_frequencies f USING search_engine.documents d "
+                "WHERE f.document_id = d.id AND d.url IN (SELECT url FROM index_staging_aliases); "
+                "DELETE FROM search_engine.documents WHERE url IN (SELECT url FROM index_staging_aliases); "
+                "UPDATE search_engine.document_aliases a SET canonical_url = s.canonical_url "
+                "FROM index_staging_aliases s WHERE a.canonical_url = s.url");
+        }
+
+        // Буфер позиций переиспользуется: BYTEA пишется из basic_string<std::byte>
+        DocumentStore::Bytes positions;
+        auto words = pqxx::stream_to::table(txn, { "index_staging_postings" }, { "url", "word_id", "frequency", "positions" });
+        for (const auto& page : batch) {
+            std::size_t offset = 0;
+            for (const auto& count : page.counts) {
+                positions.assign(reinterpret_cast<const std::byte*>(page.positions.data() + offset), count.positions_length);
+                offset += count.positions_length;
+                words.write_values(page.url, word_ids[postings], count.frequency, positions);
+                postings++;
+            }
+        }
+        words.complete();
+
+        // Четыре команды одним запросом. Страница, бывшая псевдонимом, теперь
+        // записана документом и псевдонимом больше не считается. Документ
+        // перезаписывается, только если изменился отпечаток содержимого.
+        // Частоты обновляются разностью: удаляются слова, которых на странице
+        // больше нет, вставляются новые, меняются только отличающиеся частоты
+        // и позиции, остальные строки не трогаются.
+        txn.exec(
+            "DELETE FROM search_engine.document_aliases WHERE url IN (SELECT url FROM index_staging_documents); "
+            "INSERT INTO search_engine.documents (url, content, content_zstd, etag, last_modified, content_hash, depth, length) "
+            "SELECT DISTINCT ON (url) url, content, content_zstd, etag, last_modified, content_hash, depth, length "
+            "FROM index_staging_documents "
+            "ON CONFLICT (url) DO UPDATE SET content = EXCLUDED.content, content_zstd = EXCLUDED.content_zstd, "
+            "etag = EXCLUDED.etag, last_modified = EXCLUDED.last_modified, content_hash = EXCLUDED.content_hash, "
+            "depth = LEAST(documents.depth, EXCLUDED.depth), length = EXCLUDED.length "
+            "WHERE documents.content_hash IS DISTINCT FROM EXCLUDED.content_hash; "
+            "DELETE FROM search_engine.word_frequencies f USING search_engine.documents d "
+            "WHERE f.document_id = d.id AND d.url IN (SELECT url FROM index_staging_documents) "
+            "AND NOT EXISTS (SELECT 1 FROM index_staging_postings s WHERE s.url = d.url AND s.word_id = f.word_id); "
+            "INSERT INTO search_engine.word_frequencies (document_id, word_id, frequency, positions) "
+            "SELECT d.id, s.word_id, s.frequency, s.positions FROM index_staging_postings s "
+            "JOIN search_engine.documents d ON d.url = s.url "
+            "ON CONFLICT (document_id, word_id) DO UPDATE SET frequency = EXCLUDED.frequency, positions = EXCLUDED.positions "
+            "WHERE (word_frequencies.frequency, word_frequencies.positions) IS DISTINCT FROM "
+            "(EXCLUDED.frequency, EXCLUDED.positions)");
+        txn.commit();
+
+        // Словарь пополняется только после успешной записи слов в базу
+        TermDictionary& dictionary = db_.terms();
+        for (const auto& [word, id] : new_terms) {
+            dictionary.insert(word, id);
+        }
+
+        pages_ += batch.size();
+        postings_ += postings;
+        aliases_ += aliases;
+        unchanged_ += unchanged;
+        stored_bytes_ += stored_bytes;
+        write_nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        batches_++;
+        return true;
+    }
+    catch (const pqxx::sql_error& e) {
+        std::cerr << "SQL error in index batch (" << batch.size() << " pages): " << e.what() << std::endl;
+        std::cerr << "Query was: " << e.query() << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Index batch error (" << batch.size() << " pages): " << e.what() << std::endl;
+    }
+    return false;
+}
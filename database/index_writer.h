@@ -0,0 +1,100 @@
+#ifndef INDEX_WRITER_H
+#define INDEX_WRITER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "database.h"
+#include "document_store.h"
+
+// Проиндексированная страница: слова и их позиции хранятся подряд в одной
+// строке каждые, чтобы на слово не приходилось отдельной аллокации
+struct IndexedPage {
+    struct WordCount {
+        std::uint32_t length;
+        int frequency;
+        std::uint32_t positions_length;
+    };
+
+    std::string url;
+    std::string alias_of; // Не пусто, если страница дублирует уже проиндексированную
+    bool unchanged = false; // Содержимое не изменилось: обновляются только валидаторы
+    std::string etag;
+    std::string last_modified;
+    std::uint64_t content_hash = 0;
+    int depth = 0;
+    int length = 0; // Число слов на странице, с повторами (для BM25)
+    std::string content;
+    DocumentStore::Bytes content_zstd; // Заполняется вместо content в режиме zstd
+    std::string words;
+    std::string positions; // Позиции слова: varint-разности номеров слов на странице
+    std::vector<WordCount> counts;
+
+    void add_word(std::string_view word, int frequency, std::string_view word_positions) {
+        words.append(word);
+        positions.append(word_positions);
+        counts.push_back(WordCount{ static_cast<std::uint32_t>(word.size()), frequency,
+            static_cast<std::uint32_t>(word_positions.size()) });
+    }
+};
+
+// Накапливает страницы и записывает их пакетом: COPY во временные таблицы
+// и INSERT ... SELECT вместо нескольких запросов на каждое слово.
+// Измененные страницы перезаписываются, их частоты обновляются разностью.
+class IndexWriter {
+public:
+    struct Stats {
+        std::size_t pages = 0;
+        std::size_t postings = 0;
+        std::size_t aliases = 0;
+        std::size_t unchanged = 0;
+        std::size_t stored_bytes = 0;
+        double write_seconds = 0;
+        std::size_t batches = 0;
+        std::size_t failed_batches = 0;
+        std::size_t failed_pages = 0; // Не записались и при повторе по одной
+    };
+
+    IndexWriter(Database& db, const Config& config);
+
+    // Потокобезопасно; при заполнении пакета записывает его в вызывающем потоке
+    void add(IndexedPage page);
+    void flush();
+
+    Stats stats() const;
+
+private:
+    void write(std::vector<IndexedPage>& batch);
+    // Один пакет в одной транзакции; false, если она откатилась
+    bool write_batch(std::vector<IndexedPage>& batch);
+    std::vector<int> resolve_word_ids(pqxx::work& txn, const std::vector<IndexedPage>& batch,
+        std::unordered_map<std::string_view, int>& new_terms);
+    void prepare_staging(const DatabasePool::Lease& conn);
+
+    Database& db_;
+    std::size_t batch_pages_;
+
+    std::mutex batch_mutex_;
+    std::vector<IndexedPage> batch_;
+
+    std::mutex sessions_mutex_;
+    std::unordered_set<std::uint64_t> staged_sessions_; // Соединения с созданными временными таблицами
+
+    std::atomic<std::size_t> pages_{ 0 };
+    std::atomic<std::size_t> postings_{ 0 };
+    std::atomic<std::size_t> aliases_{ 0 };
+    std::atomic<std::size_t> unchanged_{ 0 };
+    std::atomic<std::size_t> stored_bytes_{ 0 };
+    std::atomic<long long> write_nanoseconds_{ 0 };
+    std::atomic<std::size_t> batches_{ 0 };
+    std::atomic<std::size_t> failed_batches_{ 0 };
+    std::atomic<std::size_t> failed_pages_{ 0 };
+};
+
+#endif // INDEX_WRITER_H
@@ -0,0 +1,107 @@
+#include "term_dictionary.h"
+#include <algorithm>
+#include <stdexcept>
+
+TermDictionary::TermDictionary(std::size_t max_bytes) : max_bytes_(max_bytes) {
+}
+
+TermDictionary::Shard& TermDictionary::shard_for(std::string_view word) {
+    return shards_[Hash{}(word) % kShards];
+}
+
+const TermDictionary::Shard& TermDictionary::shard_for(std::string_view word) const {
+    return shards_[Hash{}(word) % kShards];
+}
+
+// Оценка памяти узла unordered_map: строка, значение, указатель на следующий
+// узел, сохраненный хэш, ячейка корзины и буфер строки, если она не влезла в SSO
+std::size_t TermDictionary::entry_bytes(const std::string& word) {
+    std::size_t bytes = sizeof(std::string) + sizeof(int) + 3 * sizeof(void*);
+    if (word.capacity() > 15) {
+        bytes += word.capacity() + 1;
+    }
+    return bytes;
+}
+
+std::size_t TermDictionary::warm(pqxx::connection& conn) {
+    std::size_t loaded = 0;
+    pqxx::work txn(conn);
+    auto stream = pqxx::stream_from::query(txn, "SELECT id, word FROM search_engine.words");
+    for (auto [id, word] : stream.iter<int, std::string_view>()) {
+        if (bytes_ >= max_bytes_) {
+            rejected_++;
+            continue;
+        }
+        insert(word, id);
+        loaded++;
+    }
+    stream.complete();
+    txn.commit();
+    return loaded;
+}
+
+std::optional<int> TermDictionary::find(std::string_view word) const {
+    const Shard& shard = shard_for(word);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.terms.find(word);
+    if (it == shard.terms.end()) {
+        misses_++;
+        return std::nullopt;
+    }
+    hits_++;
+    return it->second;
+}
+
+void TermDictionary::insert(std::string_view word, int id) {
+    Shard& shard = shard_for(word);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.terms.find(word);
+    if (it != shard.terms.end()) {
+        it->second = id;
+        return;
+    }
+
+    std::string key(word);
+    std::size_t const bytes = entry_bytes(key);
+    if (bytes_ + bytes > max_bytes_) {
+        rejected_++;
+        return;
+    }
+    shard.terms.emplace(std::move(key), id);
+    bytes_ += bytes;
+    terms_++;
+}
+
+std::vector<int> TermDictionary::reserve_ids(pqxx::work& txn, std::size_t count) {
+    std::lock_guard<std::mutex> lock(ids_mutex_);
+    if (free_ids_.size() < count) {
+        std::size_t const need = std::max(kIdBlock, count - free_ids_.size());
+        // Значения последовательности не откатываются вместе с транзакцией,
+        // поэтому блок остается за этим процессом в любом случае
+        pqxx::result r = txn.exec_params(
+            "SELECT nextval(pg_get_serial_sequence('search_engine.words', 'id')) FROM generate_series(1, $1)",
+            static_cast<long long>(need));
+        free_ids_.reserve(free_ids_.size() + r.size());
+        for (const auto& row : r) {
+            free_ids_.push_back(row[0].as<int>());
+        }
+        if (free_ids_.size() < count) {
+            throw std::runtime_error("Failed to reserve word ids from the sequence");
+        }
+    }
+
+    std::vector<int> ids(free_ids_.end() - count, free_ids_.end());
+    free_ids_.resize(free_ids_.size() - count);
+    return ids;
+}
+
+TermDictionary::Stats TermDictionary::stats() const {
+    Stats stats;
+    stats.terms = terms_;
+    stats.bytes = bytes_;
+    stats.max_bytes = max_bytes_;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.rejected = rejected_;
+    return stats;
+}
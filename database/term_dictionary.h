@@ -0,0 +1,74 @@
+#ifndef TERM_DICTIONARY_H
+#define TERM_DICTIONARY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+// Общий для всех потоков кэш слово -> words.id. Заполняется из базы при
+// старте; новые идентификаторы берутся из последовательности диапазонами.
+// Объем ограничен: при достижении предела новые слова не кэшируются.
+class TermDictionary {
+public:
+    struct Stats {
+        std::size_t terms = 0;
+        std::size_t bytes = 0;
+        std::size_t max_bytes = 0;
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t rejected = 0;
+    };
+
+    explicit TermDictionary(std::size_t max_bytes);
+
+    // Загружает словарь из search_engine.words; возвращает число загруженных слов
+    std::size_t warm(pqxx::connection& conn);
+
+    std::optional<int> find(std::string_view word) const;
+    void insert(std::string_view word, int id);
+
+    // Выдает count новых идентификаторов. Они берутся блоками через nextval,
+    // остаток блока хранится до следующего вызова.
+    std::vector<int> reserve_ids(pqxx::work& txn, std::size_t count);
+
+    Stats stats() const;
+
+private:
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, int, Hash, std::equal_to<>> terms;
+    };
+
+    static constexpr std::size_t kShards = 64;
+    static constexpr std::size_t kIdBlock = 4096;
+
+    Shard& shard_for(std::string_view word);
+    const Shard& shard_for(std::string_view word) const;
+    static std::size_t entry_bytes(const std::string& word);
+
+    std::array<Shard, kShards> shards_;
+    std::size_t max_bytes_;
+    std::atomic<std::size_t> bytes_{ 0 };
+    std::atomic<std::size_t> terms_{ 0 };
+    mutable std::atomic<std::size_t> hits_{ 0 };
+    mutable std::atomic<std::size_t> misses_{ 0 };
+    std::atomic<std::size_t> rejected_{ 0 };
+
+    std::mutex ids_mutex_;
+    std::vector<int> free_ids_; // Зарезервированные, но еще не выданные id
+};
+
+#endif // TERM_DICTIONARY_H
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include "bench/test_server.h"
+#include "bench/web_graph.h"
+#include "config/config.h"
+#include "database/database.h"
+#include "spider/spider.h"
+
+namespace {
+
+void print_usage() {
+    std::cout << "Usage: CrawlBenchmark [options]\n"
+        << "  --config PATH        config.ini (database and spider settings)\n"
+        << "  --db-name NAME       database to index into instead of the one in the config\n"
+        << "  --pages N            pages in the generated site (10000)\n"
+        << "  --fanout N           links per page (10)\n"
+        << "  --page-bytes N       approximate page size (16384)\n"
+        << "  --latency-ms N       server delay before each response (0)\n"
+        << "  --error-rate F       share of pages answering 500 (0)\n"
+        << "  --seed N             graph seed (1)\n"
+        << "  --https              serve over TLS with a self-signed certificate\n"
+        << "  --server-threads N   test server threads (2)\n"
+        << "  --quiet              hide per-page spider output\n"
+        << "  --serve              only run the test server until Enter is pressed\n";
+}
+
+} // namespace
+
+// Бенчмарк обхода: паук обходит синтетический сайт на локальном сервере,
+// в конце печатаются скорость загрузки, перцентили задержек и скорость записи индекса
+int main(int argc, char* argv[]) {
+    try {
+        std::string config_path = "C:/Users/alexr/Desktop/Search_Engine/config/config.ini";
+        std::string db_name;
+        WebGraphOptions graph_options;
+        bool https = false;
+        bool quiet = false;
+        bool serve_only = false;
+        int server_threads = 2;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string const arg = argv[i];
+            bool const has_value = i + 1 < argc;
+            if (arg == "--config" && has_value) {
+                config_path = argv[++i];
+            }
+            else if (arg == "--db-name" && has_value) {
+                db_name = argv[++i];
+            }
+            else if (arg == "--pages" && has_value) {
+                graph_options.pages = std::stoull(argv[++i]);
+            }
+            else if (arg == "--fanout" && has_value) {
+                graph_options.fanout = std::stoull(argv[++i]);
+            }
+            else if (arg == "--page-bytes" && has_value) {
+                graph_options.page_bytes = std::stoull(argv[++i]);
+            }
+            else if (arg == "--latency-ms" && has_value) {
+                graph_options.latency_ms = std::stoi(argv[++i]);
+            }
+            else if (arg == "--error-rate" && has_value) {
+                graph_options.error_rate = std::stod(argv[++i]);
+            }
+            else if (arg == "--seed" && has_value) {
+                graph_options.seed = std::stoull(argv[++i]);
+            }
+            else if (arg == "--server-threads" && has_value) {
+                server_threads = std::stoi(argv[++i]);
+            }
+            else if (arg == "--https") {
+                https = true;
+            }
+            else if (arg == "--quiet") {
+                quiet = true;
+            }
+            else if (arg == "--serve") {
+                serve_only = true;
+            }
+            else {
+                print_usage();
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+
+        WebGraph graph(graph_options);
+        TestServer server(graph, https, server_threads);
+        std::string const start_url = server.base_url() + "/page/0";
+        std::cout << "Test server: " << start_url << ", " << graph_options.pages << " pages, fan-out "
+            << graph_options.fanout << ", ~" << graph_options.page_bytes << " bytes per page, latency "
+            << graph_options.latency_ms << " ms, error rate " << graph_options.error_rate << std::endl;
+
+        if (serve_only) {
+            std::cout << "Press Enter to stop" << std::endl;
+            std::cin.get();
+            return 0;
+        }
+
+        Config config = read_config(config_path);
+        if (!db_name.empty()) {
+            config.db_name = db_name;
+        }
+        // Весь сайт на одном хосте: без задержки вежливости, без ограничения глубины
+        // и без сохранения границы на диск
+        config.start_url = start_url;
+        config.recursion_depth = static_cast<int>(std::min<std::size_t>(graph_options.pages,
+            std::numeric_limits<int>::max()));
+        config.politeness_delay_ms = 0;
+        config.frontier_dir.clear();
+        config.incremental = false;
+
+        Database db(config);
+        db.create_tables();
+        db.warm_terms();
+
+        Spider::Stats stats;
+        {
+            Spider spider(config, db);
+            std::streambuf* const cout_buffer = std::cout.rdbuf();
+            if (quiet) {
+                std::cout.rdbuf(nullptr);
+            }
+            spider.start();
+            std::cout.rdbuf(cout_buffer);
+            stats = spider.stats();
+        }
+        server.stop();
+
+        auto const served = server.stats();
+        double const seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+        std::cout << "\nBenchmark results (" << (https ? "https" : "http") << ")\n"
+            << "  Crawl:         " << stats.pages_fetched << " pages in " << stats.seconds << " s, "
+            << stats.pages_fetched / seconds << " pages/s, "
+            << stats.bytes_fetched / seconds / (1024 * 1024) << " MiB/s\n"
+            << "  Fetch latency: p50 " << stats.fetch_p50_ms << " ms, p99 " << stats.fetch_p99_ms << " ms\n"
+            << "  Index:         " << stats.index.pages << " pages, " << stats.index.postings << " postings, "
+            << stats.index.pages / seconds << " pages/s overall";
+        if (stats.index.write_seconds > 0) {
+            std::cout << ", " << stats.index.postings / stats.index.write_seconds << " postings/s while writing";
+        }
+        std::cout << " (" << stats.index.failed_batches << " failed batches, " << stats.index.failed_pages << " pages lost)\n"
+            << "  Server:        " << served.requests << " requests on " << served.connections << " connections, "
+            << served.errors << " errors, " << served.bytes / (1024 * 1024) << " MiB served" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception in main: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
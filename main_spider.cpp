@@ -1,12 +1,32 @@
 #include <iostream>
+#include <string>
+#include <vector>
 #include <pqxx/pqxx>
 #include "config/config.h"
 #include "database/database.h"
 #include "spider/spider.h"
 #include "search_engine/search_engine.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        // --resume: продолжить прерванный обход с последней контрольной точки
+        // --warc файл...: проиндексировать страницы из WARC-файлов без обхода сети
+        bool resume = false;
+        std::vector<std::string> warc_files;
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--resume") {
+                resume = true;
+            }
+            else if (std::string(argv[i]) == "--warc") {
+                while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                    warc_files.push_back(argv[++i]);
+                }
+            }
+            else {
+                std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            }
+        }
+
         std::string config_path = "C:/Users/alexr/Desktop/Search_Engine/config/config.ini";
         std::cout << "Reading config from: " << config_path << std::endl;
         Config config = read_config(config_path);
@@ -16,13 +36,19 @@ int main() {
         Database db(config);
         std::cout << "Database initialized." << std::endl;
 
-        //      Database
+        // Создаём таблицы через метод класса Database
         db.create_tables();
+        db.warm_terms();
 
         std::cout << "Starting spider..." << std::endl;
         Spider spider(config, db);
 
-        spider.start();
+        if (!warc_files.empty()) {
+            spider.ingest(warc_files);
+        }
+        else {
+            spider.start(resume);
+        }
         std::cout << "Spider finished." << std::endl;
     }
     catch (const std::exception& e) {
@@ -0,0 +1,409 @@
+#include "inverted_index.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace {
+
+constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+// Таблица id из базы -> плотный номер. Идентификаторы SERIAL идут почти
+// подряд, поэтому вектор, индексируемый id, компактнее хэш-таблицы.
+void assign(std::vector<std::uint32_t>& map, int id, std::uint32_t value) {
+    if (id < 0) {
+        return;
+    }
+    std::size_t const index = static_cast<std::size_t>(id);
+    if (index >= map.size()) {
+        map.resize(std::max(index + 1, map.size() * 2), kNone);
+    }
+    map[index] = value;
+}
+
+std::uint32_t lookup(const std::vector<std::uint32_t>& map, int id) {
+    return id >= 0 && static_cast<std::size_t>(id) < map.size() ? map[static_cast<std::size_t>(id)] : kNone;
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Дописывает BYTEA в формате hex ("\x0a81...") в out. Данные из базы
+// проверяются: хвост с оборванным или слишком длинным varint отбрасывается,
+// чтобы курсор мог читать позиции без проверок границ.
+void append_bytea(std::string_view text, std::vector<std::uint8_t>& out) {
+    if (text.size() < 2 || text[0] != '\\' || text[1] != 'x') {
+        return;
+    }
+    std::size_t const start = out.size();
+    std::size_t valid = start;
+    unsigned varint_bytes = 0;
+    for (std::size_t i = 2; i + 1 < text.size(); i += 2) {
+        int const high = hex_digit(text[i]);
+        int const low = hex_digit(text[i + 1]);
+        if (high < 0 || low < 0) {
+            break;
+        }
+        auto const byte = static_cast<std::uint8_t>(high * 16 + low);
+        out.push_back(byte);
+        if (++varint_bytes > 5) {
+            break;
+        }
+        if (byte < 0x80) {
+            valid = out.size();
+            varint_bytes = 0;
+        }
+    }
+    out.resize(valid);
+}
+
+} // namespace
+
+InvertedIndex::InvertedIndex(const Config& config)
+    : k1_(static_cast<float>(std::max(0.0, config.bm25_k1))), b_(static_cast<float>(std::clamp(config.bm25_b, 0.0, 1.0))),
+    k1_plus_one_(k1_ + 1) {
+}
+
+void InvertedIndex::load(pqxx::connection& conn) {
+    auto const started = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, std::uint32_t, Hash, std::equal_to<>> terms;
+    std::vector<std::uint64_t> term_offsets;
+    std::vector<Posting> postings;
+    std::string urls;
+    std::vector<std::uint64_t> url_offsets;
+
+    pqxx::work txn(conn);
+    // Четыре запроса ниже должны видеть одно и то же состояние базы,
+    // даже если паук в это время пишет новые страницы
+    txn.exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    txn.exec("SET LOCAL bytea_output = 'hex'");
+
+    std::vector<std::uint32_t> document_by_id;
+    std::vector<std::uint32_t> lengths;
+    {
+        auto stream = pqxx::stream_from::query(txn, "SELECT id, url, length FROM search_engine.documents ORDER BY id");
+        for (auto [id, url, length] : stream.iter<int, std::optional<std::string_view>, std::optional<int>>()) {
+            assign(document_by_id, id, static_cast<std::uint32_t>(url_offsets.size()));
+            url_offsets.push_back(urls.size());
+            urls.append(url.value_or(""));
+            lengths.push_back(static_cast<std::uint32_t>(std::max(0, length.value_or(0))));
+        }
+        stream.complete();
+    }
+    url_offsets.push_back(urls.size());
+
+    std::vector<std::uint32_t> term_by_id;
+    {
+        auto stream = pqxx::stream_from::query(txn, "SELECT id, word FROM search_engine.words");
+        for (auto [id, word] : stream.iter<int, std::string_view>()) {
+            auto const [it, inserted] = terms.try_emplace(std::string(word), static_cast<std::uint32_t>(terms.size()));
+            assign(term_by_id, id, it->second);
+        }
+        stream.complete();
+    }
+
+    // Размер отрезка каждого слова известен заранее: вхождения раскладываются
+    // сразу на свои места, без промежуточных списков
+    term_offsets.assign(terms.size() + 1, 0);
+    {
+        auto stream = pqxx::stream_from::query(txn,
+            "SELECT word_id, COUNT(*) FROM search_engine.word_frequencies GROUP BY word_id");
+        for (auto [word_id, count] : stream.iter<int, long long>()) {
+            std::uint32_t const term = lookup(term_by_id, word_id);
+            if (term != kNone) {
+                term_offsets[term + 1] += static_cast<std::uint64_t>(count);
+            }
+        }
+        stream.complete();
+    }
+    for (std::size_t i = 1; i < term_offsets.size(); ++i) {
+        term_offsets[i] += term_offsets[i - 1];
+    }
+
+    postings.resize(term_offsets.back());
+    std::vector<std::uint64_t> fill(term_offsets.begin(), term_offsets.end() - 1);
+    std::vector<std::uint32_t> frequency_sums(lengths.size(), 0);
+    std::vector<std::uint8_t> raw_positions;
+    {
+        auto stream = pqxx::stream_from::query(txn,
+            "SELECT word_id, document_id, frequency, positions FROM search_engine.word_frequencies");
+        for (auto [word_id, document_id, frequency, positions] :
+            stream.iter<int, int, std::optional<int>, std::optional<std::string_view>>()) {
+            std::uint32_t const term = lookup(term_by_id, word_id);
+            std::uint32_t const document = lookup(document_by_id, document_id);
+            if (term == kNone || document == kNone || fill[term] == term_offsets[term + 1]) {
+                continue;
+            }
+            Posting& posting = postings[fill[term]++];
+            posting = { document, static_cast<std::uint32_t>(std::max(0, frequency.value_or(0))), raw_positions.size(), 0 };
+            if (positions) {
+                append_bytea(*positions, raw_positions);
+                posting.positions_size = static_cast<std::uint32_t>(raw_positions.size() - posting.positions);
+            }
+            frequency_sums[document] += posting.frequency;
+        }
+        stream.complete();
+    }
+    txn.commit();
+
+    // Страницы, записанные до появления documents.length: длина - сумма частот
+    double total_length = 0;
+    for (std::size_t document = 0; document < lengths.size(); ++document) {
+        if (lengths[document] == 0) {
+            lengths[document] = frequency_sums[document];
+        }
+        total_length += lengths[document];
+    }
+    double const average_length = lengths.empty() || total_length == 0 ? 1 : total_length / lengths.size();
+    norms_.resize(lengths.size());
+    for (std::size_t document = 0; document < lengths.size(); ++document) {
+        norms_[document] = static_cast<float>(k1_ * (1 - b_ + b_ * lengths[document] / average_length));
+    }
+
+    // Строки приходят в порядке хранения таблицы; обычно это уже порядок
+    // документов, и сортировка сводится к проверке
+    std::vector<std::uint64_t> term_blocks(terms.size());
+    std::vector<std::uint32_t> term_sizes(terms.size());
+    std::vector<float> term_weights(terms.size());
+    blocks_.clear();
+    data_.clear();
+    positions_.clear();
+    for (std::size_t term = 0; term < terms.size(); ++term) {
+        auto const begin = postings.begin() + static_cast<std::ptrdiff_t>(term_offsets[term]);
+        auto const end = postings.begin() + static_cast<std::ptrdiff_t>(fill[term]);
+        auto const by_document = [](const Posting& a, const Posting& b) { return a.document < b.document; };
+        if (!std::is_sorted(begin, end, by_document)) {
+            std::sort(begin, end, by_document);
+        }
+        term_blocks[term] = blocks_.size();
+        term_sizes[term] = static_cast<std::uint32_t>(end - begin);
+        encode(postings.data() + term_offsets[term], static_cast<std::size_t>(end - begin), raw_positions);
+        for (std::size_t block = term_blocks[term]; block < blocks_.size(); ++block) {
+            term_weights[term] = std::max(term_weights[term], blocks_[block].max_weight);
+        }
+    }
+    blocks_.shrink_to_fit();
+    data_.shrink_to_fit();
+    positions_.shrink_to_fit();
+
+    terms_ = std::move(terms);
+    term_blocks_ = std::move(term_blocks);
+    term_sizes_ = std::move(term_sizes);
+    term_weights_ = std::move(term_weights);
+    urls_ = std::move(urls);
+    url_offsets_ = std::move(url_offsets);
+
+    stats_.documents = document_count();
+    stats_.terms = terms_.size();
+    stats_.postings = 0;
+    for (std::uint32_t size : term_sizes_) {
+        stats_.postings += size;
+    }
+    stats_.raw_bytes = stats_.postings * 2 * sizeof(std::uint32_t);
+    stats_.position_bytes = positions_.size();
+    stats_.bytes = memory_bytes();
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+void InvertedIndex::encode(const Posting* postings, std::size_t count, const std::vector<std::uint8_t>& raw_positions) {
+    std::uint32_t previous = 0;
+    std::uint32_t documents[kPostingBlock];
+    std::uint32_t frequencies[kPostingBlock];
+    for (std::size_t start = 0; start < count; start += kPostingBlock) {
+        std::size_t const n = std::min(kPostingBlock, count - start);
+        Block block;
+        block.offset = data_.size();
+        block.positions = positions_.size();
+        block.last_document = postings[start + n - 1].document;
+        for (std::size_t i = 0; i < n; ++i) {
+            // Частота не меньше 1 хранится как frequency - 1: блоки из
+            // единичных частот занимают ноль бит
+            std::uint32_t const frequency = std::max<std::uint32_t>(1, postings[start + i].frequency);
+            documents[i] = postings[start + i].document - previous;
+            frequencies[i] = frequency - 1;
+            previous = postings[start + i].document;
+            block.max_frequency = std::max(block.max_frequency, frequency);
+            block.max_weight = std::max(block.max_weight, weight(static_cast<float>(frequency), postings[start + i].document));
+
+            const Posting& posting = postings[start + i];
+            put_varint(posting.positions_size, positions_);
+            positions_.insert(positions_.end(), raw_positions.begin() + static_cast<std::ptrdiff_t>(posting.positions),
+                raw_positions.begin() + static_cast<std::ptrdiff_t>(posting.positions + posting.positions_size));
+        }
+
+        if (n == kPostingBlock) {
+            block.document_bits = static_cast<std::uint8_t>(bits_needed(documents, n));
+            block.frequency_bits = static_cast<std::uint8_t>(bits_needed(frequencies, n));
+            pack_block(documents, block.document_bits, data_);
+            pack_block(frequencies, block.frequency_bits, data_);
+        }
+        else {
+            for (std::size_t i = 0; i < n; ++i) {
+                put_varint(documents[i], data_);
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                put_varint(frequencies[i], data_);
+            }
+        }
+        blocks_.push_back(block);
+    }
+}
+
+InvertedIndex::Cursor InvertedIndex::postings(std::string_view term) const {
+    auto it = terms_.find(term);
+    if (it == terms_.end() || term_sizes_[it->second] == 0) {
+        return {};
+    }
+    return Cursor(*this, it->second);
+}
+
+std::string_view InvertedIndex::url(std::uint32_t document) const {
+    std::uint64_t const begin = url_offsets_[document];
+    std::uint64_t const end = url_offsets_[document + 1];
+    return std::string_view(urls_).substr(static_cast<std::size_t>(begin), static_cast<std::size_t>(end - begin));
+}
+
+// Оценка: массивы по емкости, узлы словаря как в TermDictionary::entry_bytes
+std::size_t InvertedIndex::memory_bytes() const {
+    std::size_t bytes = blocks_.capacity() * sizeof(Block) + data_.capacity() + positions_.capacity() +
+        term_blocks_.capacity() * sizeof(std::uint64_t) + term_sizes_.capacity() * sizeof(std::uint32_t) +
+        term_weights_.capacity() * sizeof(float) + norms_.capacity() * sizeof(float) +
+        url_offsets_.capacity() * sizeof(std::uint64_t) +
+        urls_.capacity();
+    for (const auto& [term, index] : terms_) {
+        bytes += sizeof(std::string) + sizeof(index) + 3 * sizeof(void*);
+        if (term.capacity() > 15) {
+            bytes += term.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+InvertedIndex::Cursor::Cursor(const InvertedIndex& index, std::uint32_t term)
+    : index_(&index), first_(index.blocks_.data() + index.term_blocks_[term]), block_(first_),
+    end_(first_ + (index.term_sizes_[term] + kPostingBlock - 1) / kPostingBlock), probe_(first_),
+    data_(index.data_.data()), count_(index.term_sizes_[term]), max_weight_(index.term_weights_[term]) {
+    // idf по Робертсону - Спарк Джонс, всегда положительный
+    double const documents = static_cast<double>(index.document_count());
+    double const df = static_cast<double>(count_);
+    idf_ = static_cast<float>(std::log(1 + (documents - df + 0.5) / (df + 0.5)));
+    load_block();
+}
+
+void InvertedIndex::Cursor::load_block() {
+    std::size_t const index = static_cast<std::size_t>(block_ - first_);
+    std::uint32_t const base = index == 0 ? 0 : block_[-1].last_document;
+    const std::uint8_t* in = data_ + block_->offset;
+    size_ = static_cast<unsigned>(std::min(kPostingBlock, count_ - index * kPostingBlock));
+    position_ = 0;
+    positions_ = index_->positions_.data() + block_->positions;
+    positions_index_ = 0;
+    if (size_ == kPostingBlock) {
+        unpack_deltas(in, block_->document_bits, base, documents_.data());
+        frequencies_ready_ = false;
+    }
+    else {
+        // Хвост в varint распаковывается целиком
+        std::uint32_t document = base;
+        for (unsigned i = 0; i < size_; ++i) {
+            std::uint32_t delta;
+            in = get_varint(in, delta);
+            document += delta;
+            documents_[i] = document;
+        }
+        for (unsigned i = 0; i < size_; ++i) {
+            in = get_varint(in, frequencies_[i]);
+            frequencies_[i]++;
+        }
+        frequencies_ready_ = true;
+    }
+    document_ = documents_[0];
+}
+
+std::uint32_t InvertedIndex::Cursor::frequency() {
+    if (!frequencies_ready_) {
+        unpack_block(data_ + block_->offset + block_->document_bits * 16u, block_->frequency_bits, frequencies_.data());
+        for (auto& frequency : frequencies_) {
+            frequency++;
+        }
+        frequencies_ready_ = true;
+    }
+    return frequencies_[position_];
+}
+
+void InvertedIndex::Cursor::positions(std::vector<std::uint32_t>& out) {
+    out.clear();
+    if (at_end()) {
+        return;
+    }
+    // Списки вхождений блока идут подряд: пропускаются по длинам, и чтение
+    // продолжается с последнего места, пока курсор не сменит блок
+    std::uint32_t size;
+    while (positions_index_ < position_) {
+        positions_ = get_varint(positions_, size) + size;
+        positions_index_++;
+    }
+    const std::uint8_t* in = get_varint(positions_, size);
+    const std::uint8_t* const end = in + size;
+    std::uint32_t position = 0;
+    while (in < end) {
+        std::uint32_t delta;
+        in = get_varint(in, delta);
+        position += delta;
+        out.push_back(position);
+    }
+}
+
+float InvertedIndex::Cursor::score() {
+    return idf_ * index_->weight(static_cast<float>(frequency()), document_);
+}
+
+void InvertedIndex::Cursor::next() {
+    if (at_end()) {
+        return;
+    }
+    if (++position_ < size_) {
+        document_ = documents_[position_];
+        return;
+    }
+    if (++block_ == end_) {
+        document_ = kEnd;
+        return;
+    }
+    load_block();
+}
+
+void InvertedIndex::Cursor::advance(std::uint32_t target) {
+    if (at_end() || document_ >= target) {
+        return;
+    }
+    if (block_->last_document < target) {
+        // Блоки, целиком лежащие левее target, пропускаются без распаковки
+        do {
+            ++block_;
+        } while (block_ != end_ && block_->last_document < target);
+        if (block_ == end_) {
+            document_ = kEnd;
+            return;
+        }
+        load_block();
+    }
+    position_ = lower_bound_block(documents_.data(), position_, size_, target);
+    document_ = documents_[position_];
+}
+
+const InvertedIndex::Block* InvertedIndex::Cursor::seek_block(std::uint32_t target) {
+    // Обычно target не убывает между вызовами, и поиск продолжается с прошлого места
+    if (probe_ < block_ || (probe_ > block_ && probe_[-1].last_document >= target)) {
+        probe_ = block_;
+    }
+    while (probe_ != end_ && probe_->last_document < target) {
+        ++probe_;
+    }
+    return probe_ == end_ ? nullptr : probe_;
+}
@@ -0,0 +1,171 @@
+#ifndef INVERTED_INDEX_H
+#define INVERTED_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+#include "../config/config.h"
+#include "posting_codec.h"
+
+// Инвертированный индекс в памяти процесса. Загружается из words и
+// word_frequencies при старте сервера и дальше только читается, поэтому
+// запросы из разных потоков обходятся без блокировок. Источником истины
+// остается PostgreSQL: индекс - ее снимок на момент загрузки.
+//
+// Документы перенумерованы подряд (0..N-1) в порядке documents.id. Вхождения
+// каждого слова отсортированы по номеру документа и сжаты блоками по 128:
+// разности номеров и частоты упакованы с разрядностью блока (posting_codec.h),
+// неполный последний блок хранится в varint. У каждого блока есть данные
+// пропуска - последний номер документа, наибольшая частота и наибольший вклад
+// в BM25, по которым Block-Max WAND пропускает блоки целиком.
+//
+// Позиции слова в документе (word_frequencies.positions) лежат отдельно от
+// блоков, в том же порядке, что и вхождения: у каждого вхождения длина списка
+// в байтах и varint-разности номеров слов. Блок помнит, где начинаются
+// позиции его первого вхождения, поэтому курсор читает их только для тех
+// документов, о которых спросили, и запросы без фраз их не касаются.
+//
+// BM25: idf(t) * w(f, d), где w = f * (k1 + 1) / (f + k1 * (1 - b + b * |d| / avgdl)).
+// Длины документов записывает паук (documents.length), число документов со
+// словом - это длина его списка вхождений.
+class InvertedIndex {
+public:
+    struct Posting {
+        std::uint32_t document = 0;
+        std::uint32_t frequency = 0;
+        std::uint64_t positions = 0;       // Начало позиций в буфере загрузки
+        std::uint32_t positions_size = 0;  // Их длина в байтах
+    };
+
+    struct Block {
+        std::uint64_t offset = 0;         // Начало данных блока в data_
+        std::uint64_t positions = 0;      // Начало позиций первого вхождения в positions_
+        std::uint32_t last_document = 0;  // Наибольший номер документа в блоке
+        std::uint32_t max_frequency = 0;  // Наибольшая частота в блоке
+        float max_weight = 0;             // Наибольший w(f, d) в блоке
+        std::uint8_t document_bits = 0;
+        std::uint8_t frequency_bits = 0;
+    };
+
+    // Курсор по вхождениям одного слова. Номера документов распаковываются
+    // поблочно по мере движения, частоты - только если их спросили;
+    // advance() перескакивает блоки по данным пропуска, не распаковывая их.
+    class Cursor {
+    public:
+        static constexpr std::uint32_t kEnd = std::numeric_limits<std::uint32_t>::max();
+
+        Cursor() = default;
+
+        // Число документов со словом
+        std::size_t size() const { return count_; }
+        bool at_end() const { return document_ == kEnd; }
+        std::uint32_t document() const { return document_; }
+        std::uint32_t frequency();
+        const Block& block() const { return *block_; }
+
+        // Вклад слова в BM25 текущего документа и его верхние границы
+        float idf() const { return idf_; }
+        float score();
+        float max_score() const { return idf_ * max_weight_; }
+        float block_max_score(const Block& block) const { return idf_ * block.max_weight; }
+
+        // Позиции слова в текущем документе по возрастанию; пусто, если
+        // страница проиндексирована без позиций
+        void positions(std::vector<std::uint32_t>& out);
+
+        void next();
+        // Переходит к первому документу >= target
+        void advance(std::uint32_t target);
+        // Блок, в котором лежал бы target, без перемещения курсора и распаковки;
+        // nullptr, если все вхождения меньше target
+        const Block* seek_block(std::uint32_t target);
+
+    private:
+        friend class InvertedIndex;
+        Cursor(const InvertedIndex& index, std::uint32_t term);
+
+        void load_block();
+
+        const InvertedIndex* index_ = nullptr;
+        const Block* first_ = nullptr;
+        const Block* block_ = nullptr;
+        const Block* end_ = nullptr;
+        const Block* probe_ = nullptr;  // Последний результат seek_block
+        const std::uint8_t* data_ = nullptr;
+        const std::uint8_t* positions_ = nullptr;
+        unsigned positions_index_ = 0;          // Вхождение блока, на чьи позиции указывает positions_
+        std::size_t count_ = 0;
+        float idf_ = 0;
+        float max_weight_ = 0;
+        std::uint32_t document_ = kEnd;
+        unsigned position_ = 0;
+        unsigned size_ = 0;  // Вхождений в текущем блоке
+        bool frequencies_ready_ = false;
+        std::array<std::uint32_t, kPostingBlock> documents_;
+        std::array<std::uint32_t, kPostingBlock> frequencies_;
+    };
+
+    explicit InvertedIndex(const Config& config);
+
+    struct Stats {
+        std::size_t documents = 0;
+        std::size_t terms = 0;
+        std::size_t postings = 0;
+        std::size_t bytes = 0;
+        std::size_t raw_bytes = 0; // Те же вхождения без сжатия, по 8 байт
+        std::size_t position_bytes = 0;
+        double seconds = 0;        // Время загрузки
+    };
+
+    // Загружает индекс одним снимком базы (REPEATABLE READ), заменяя прежний
+    void load(pqxx::connection& conn);
+
+    // Курсор по вхождениям слова; пустой (сразу at_end), если слова нет
+    Cursor postings(std::string_view term) const;
+
+    std::string_view url(std::uint32_t document) const;
+    std::size_t document_count() const { return url_offsets_.empty() ? 0 : url_offsets_.size() - 1; }
+    std::size_t term_count() const { return terms_.size(); }
+    const Stats& stats() const { return stats_; }
+
+    // Составляющая BM25, не зависящая от слова. Частота дробная, чтобы тем же
+    // насыщением оценивать близость слов (query_evaluator.h).
+    float weight(float frequency, std::uint32_t document) const {
+        return frequency * k1_plus_one_ / (frequency + norms_[document]);
+    }
+
+private:
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    // Сжимает вхождения одного слова, дописывая блоки в blocks_ и data_,
+    // а их позиции из буфера загрузки raw_positions - в positions_
+    void encode(const Posting* postings, std::size_t count, const std::vector<std::uint8_t>& raw_positions);
+    std::size_t memory_bytes() const;
+
+    std::unordered_map<std::string, std::uint32_t, Hash, std::equal_to<>> terms_; // Слово -> номер слова
+    std::vector<std::uint64_t> term_blocks_;  // Первый блок слова в blocks_
+    std::vector<std::uint32_t> term_sizes_;   // Число вхождений слова
+    std::vector<float> term_weights_;         // Наибольший w(f, d) по всем вхождениям слова
+    std::vector<Block> blocks_;
+    std::vector<std::uint8_t> data_;
+    std::vector<std::uint8_t> positions_;
+    std::string urls_;                        // URL всех документов подряд
+    std::vector<std::uint64_t> url_offsets_;  // Начало URL документа в urls_, на одно больше числа документов
+    std::vector<float> norms_;                // k1 * (1 - b + b * |d| / avgdl) для каждого документа
+    float k1_;
+    float b_;
+    float k1_plus_one_;
+    Stats stats_;
+};
+
+#endif // INVERTED_INDEX_H
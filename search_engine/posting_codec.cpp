@@ -0,0 +1,282 @@
+#include "posting_codec.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define POSTING_CODEC_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POSTING_CODEC_SSE2 1
+#endif
+
+namespace {
+
+constexpr unsigned kLanes = 4;
+constexpr unsigned kRows = kPostingBlock / kLanes;
+
+constexpr std::uint32_t low_mask(unsigned bits) {
+    return bits >= 32 ? ~0u : (1u << bits) - 1;
+}
+
+using Unpacker = void (*)(const std::uint8_t*, std::uint32_t*, std::uint32_t);
+
+// Распаковщики ниже - шаблоны по разрядности и номеру строки: все сдвиги
+// и смещения известны при компиляции, цикл по строкам развернут полностью
+
+#if defined(POSTING_CODEC_AVX2)
+
+inline __m128i load_word(const std::uint8_t* in, unsigned word) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + word * 16));
+}
+
+inline __m256i load_words(const std::uint8_t* in, unsigned low, unsigned high) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(load_word(in, low)), load_word(in, high), 1);
+}
+
+// Сумма с накоплением по восьми соседним числам плюс перенос из предыдущих строк
+inline __m256i prefix_sum(__m256i v, __m256i& carry) {
+    v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+    v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+    __m256i const low_total = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3));
+    v = _mm256_add_epi32(v, _mm256_blend_epi32(_mm256_setzero_si256(), low_total, 0xF0));
+    v = _mm256_add_epi32(v, carry);
+    carry = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(7));
+    return v;
+}
+
+// Строки Row и Row + 1 в одном регистре; у половин свои сдвиги (vpsrlvd).
+// Сдвиг на 32 дает ноль, поэтому половина без переноса в следующее слово
+// просто читает свое слово повторно.
+template <unsigned Bits, bool Delta, unsigned Row>
+inline void unpack_rows(const std::uint8_t* in, std::uint32_t* out, __m256i& carry) {
+    __m256i v = _mm256_setzero_si256();
+    if constexpr (Bits > 0) {
+        constexpr unsigned word0 = Row * Bits / 32, shift0 = Row * Bits % 32;
+        constexpr unsigned word1 = (Row + 1) * Bits / 32, shift1 = (Row + 1) * Bits % 32;
+        constexpr bool spill0 = shift0 + Bits > 32, spill1 = shift1 + Bits > 32;
+
+        v = _mm256_srlv_epi32(load_words(in, word0, word1), _mm256_setr_epi32(shift0, shift0, shift0, shift0,
+            shift1, shift1, shift1, shift1));
+        if constexpr (spill0 || spill1) {
+            constexpr int left0 = spill0 ? 32 - static_cast<int>(shift0) : 32;
+            constexpr int left1 = spill1 ? 32 - static_cast<int>(shift1) : 32;
+            __m256i const next = load_words(in, spill0 ? word0 + 1 : word0, spill1 ? word1 + 1 : word1);
+            v = _mm256_or_si256(v, _mm256_sllv_epi32(next, _mm256_setr_epi32(left0, left0, left0, left0,
+                left1, left1, left1, left1)));
+        }
+        if constexpr (Bits < 32) {
+            v = _mm256_and_si256(v, _mm256_set1_epi32(static_cast<int>(low_mask(Bits))));
+        }
+    }
+    if constexpr (Delta) {
+        v = prefix_sum(v, carry);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + Row * kLanes), v);
+}
+
+template <unsigned Bits, bool Delta>
+void unpack(const std::uint8_t* in, std::uint32_t* out, std::uint32_t base) {
+    __m256i carry = _mm256_set1_epi32(static_cast<int>(base));
+    [&]<std::size_t... Pair>(std::index_sequence<Pair...>) {
+        (unpack_rows<Bits, Delta, static_cast<unsigned>(Pair * 2)>(in, out, carry), ...);
+    }(std::make_index_sequence<kRows / 2>{});
+}
+
+// Сравнение без знака через сдвиг диапазона: номера документов xor 0x80000000
+inline unsigned count_less(const std::uint32_t* values, unsigned count, std::uint32_t target) {
+    __m256i const bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    __m256i const limit = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(target)), bias);
+    unsigned less = 0;
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i const v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), bias);
+        less += static_cast<unsigned>(std::popcount(static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(limit, v))))));
+    }
+    for (; i < count; ++i) {
+        less += values[i] < target;
+    }
+    return less;
+}
+
+constexpr const char* kDecoderName = "AVX2";
+
+#elif defined(POSTING_CODEC_SSE2)
+
+inline __m128i load_word(const std::uint8_t* in, unsigned word) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + word * 16));
+}
+
+template <unsigned Bits, bool Delta, unsigned Row>
+inline void unpack_row(const std::uint8_t* in, std::uint32_t* out, __m128i& carry) {
+    __m128i v = _mm_setzero_si128();
+    if constexpr (Bits > 0) {
+        constexpr unsigned word = Row * Bits / 32, shift = Row * Bits % 32;
+        v = _mm_srli_epi32(load_word(in, word), shift);
+        if constexpr (shift + Bits > 32) {
+            v = _mm_or_si128(v, _mm_slli_epi32(load_word(in, word + 1), 32 - shift));
+        }
+        if constexpr (Bits < 32) {
+            v = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(low_mask(Bits))));
+        }
+    }
+    if constexpr (Delta) {
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, carry);
+        carry = _mm_shuffle_epi32(v, 0xFF);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + Row * kLanes), v);
+}
+
+template <unsigned Bits, bool Delta>
+void unpack(const std::uint8_t* in, std::uint32_t* out, std::uint32_t base) {
+    __m128i carry = _mm_set1_epi32(static_cast<int>(base));
+    [&]<std::size_t... Row>(std::index_sequence<Row...>) {
+        (unpack_row<Bits, Delta, static_cast<unsigned>(Row)>(in, out, carry), ...);
+    }(std::make_index_sequence<kRows>{});
+}
+
+inline unsigned count_less(const std::uint32_t* values, unsigned count, std::uint32_t target) {
+    __m128i const bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    __m128i const limit = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(target)), bias);
+    unsigned less = 0;
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i const v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), bias);
+        less += static_cast<unsigned>(std::popcount(static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, limit))))));
+    }
+    for (; i < count; ++i) {
+        less += values[i] < target;
+    }
+    return less;
+}
+
+constexpr const char* kDecoderName = "SSE2";
+
+#else
+
+inline std::uint32_t load_word(const std::uint8_t* in, unsigned word, unsigned lane) {
+    std::uint32_t value;
+    std::memcpy(&value, in + (word * kLanes + lane) * 4, sizeof(value));
+    return value;
+}
+
+template <unsigned Bits, bool Delta>
+void unpack(const std::uint8_t* in, std::uint32_t* out, std::uint32_t base) {
+    for (unsigned row = 0; row < kRows; ++row) {
+        unsigned const word = row * Bits / 32, shift = row * Bits % 32;
+        for (unsigned lane = 0; lane < kLanes; ++lane) {
+            std::uint32_t value = 0;
+            if constexpr (Bits > 0) {
+                value = load_word(in, word, lane) >> shift;
+                if constexpr (Bits < 32) {
+                    if (shift + Bits > 32) {
+                        value |= load_word(in, word + 1, lane) << (32 - shift);
+                    }
+                    value &= low_mask(Bits);
+                }
+            }
+            if constexpr (Delta) {
+                base += value;
+                value = base;
+            }
+            out[row * kLanes + lane] = value;
+        }
+    }
+}
+
+inline unsigned count_less(const std::uint32_t* values, unsigned count, std::uint32_t target) {
+    unsigned less = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        less += values[i] < target;
+    }
+    return less;
+}
+
+constexpr const char* kDecoderName = "scalar";
+
+#endif
+
+template <bool Delta, std::size_t... Bits>
+constexpr std::array<Unpacker, sizeof...(Bits)> make_unpackers(std::index_sequence<Bits...>) {
+    return { &unpack<static_cast<unsigned>(Bits), Delta>... };
+}
+
+constexpr auto kUnpackers = make_unpackers<false>(std::make_index_sequence<33>{});
+constexpr auto kDeltaUnpackers = make_unpackers<true>(std::make_index_sequence<33>{});
+
+} // namespace
+
+unsigned bits_needed(const std::uint32_t* values, std::size_t count) {
+    std::uint32_t all = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        all |= values[i];
+    }
+    return static_cast<unsigned>(std::bit_width(all));
+}
+
+void pack_block(const std::uint32_t* values, unsigned bits, std::vector<std::uint8_t>& out) {
+    std::uint32_t words[kLanes * 32] = {};
+    if (bits > 0) {
+        for (unsigned i = 0; i < kPostingBlock; ++i) {
+            unsigned const lane = i % kLanes, row = i / kLanes;
+            unsigned const word = row * bits / 32, shift = row * bits % 32;
+            std::uint32_t const value = values[i] & low_mask(bits);
+            words[word * kLanes + lane] |= value << shift;
+            if (shift + bits > 32) {
+                words[(word + 1) * kLanes + lane] |= value >> (32 - shift);
+            }
+        }
+    }
+    std::size_t const size = bits * kLanes * sizeof(std::uint32_t);
+    std::size_t const start = out.size();
+    out.resize(start + size);
+    std::memcpy(out.data() + start, words, size);
+}
+
+void unpack_block(const std::uint8_t* in, unsigned bits, std::uint32_t* values) {
+    kUnpackers[bits](in, values, 0);
+}
+
+void unpack_deltas(const std::uint8_t* in, unsigned bits, std::uint32_t base, std::uint32_t* values) {
+    kDeltaUnpackers[bits](in, values, base);
+}
+
+unsigned lower_bound_block(const std::uint32_t* values, unsigned begin, unsigned end, std::uint32_t target) {
+    unsigned step = 8;
+    while (begin + step < end && values[begin + step - 1] < target) {
+        begin += step;
+        step *= 2;
+    }
+    unsigned const count = std::min(step, end - begin);
+    return begin + count_less(values + begin, count, target);
+}
+
+void put_varint(std::uint32_t value, std::vector<std::uint8_t>& out) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+const std::uint8_t* get_varint(const std::uint8_t* in, std::uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        std::uint8_t const byte = *in++;
+        value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return in;
+        }
+    }
+}
+
+const char* posting_decoder_name() {
+    return kDecoderName;
+}
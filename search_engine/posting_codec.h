@@ -0,0 +1,40 @@
+#ifndef POSTING_CODEC_H
+#define POSTING_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Упаковка списков вхождений блоками по 128 чисел с одинаковой разрядностью.
+// Раскладка "вертикальная", по четыре 32-битные дорожки (как в SIMD-BP128):
+// число i лежит в дорожке i % 4, строка из четырех соседних чисел
+// распаковывается одной командой SSE2, две строки - одной AVX2. Блок из
+// bits-битных чисел занимает ровно bits * 16 байт.
+constexpr std::size_t kPostingBlock = 128;
+
+// Разрядность самого большого из count чисел (0 для нулей)
+unsigned bits_needed(const std::uint32_t* values, std::size_t count);
+
+// Дописывает в out 128 чисел по bits бит
+void pack_block(const std::uint32_t* values, unsigned bits, std::vector<std::uint8_t>& out);
+
+// Распаковывает 128 чисел
+void unpack_block(const std::uint8_t* in, unsigned bits, std::uint32_t* values);
+
+// Распаковывает 128 разностей и сразу восстанавливает по ним значения:
+// values[i] = base + deltas[0] + ... + deltas[i]
+void unpack_deltas(const std::uint8_t* in, unsigned bits, std::uint32_t base, std::uint32_t* values);
+
+// Первая позиция в [begin, end) отсортированного массива со значением >= target
+// (end, если таких нет). Галоп удвоением шага, затем векторный подсчет
+// значений меньше target на найденном отрезке.
+unsigned lower_bound_block(const std::uint32_t* values, unsigned begin, unsigned end, std::uint32_t target);
+
+// Неполные блоки (хвост списка) хранятся в varint: 7 бит на байт
+void put_varint(std::uint32_t value, std::vector<std::uint8_t>& out);
+const std::uint8_t* get_varint(const std::uint8_t* in, std::uint32_t& value);
+
+// Какой распаковщик собран: "AVX2", "SSE2" или "scalar"
+const char* posting_decoder_name();
+
+#endif // POSTING_CODEC_H
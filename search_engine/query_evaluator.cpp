@@ -0,0 +1,487 @@
+#include "query_evaluator.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+using Cursor = InvertedIndex::Cursor;
+constexpr std::uint32_t kEnd = Cursor::kEnd;
+
+// Итератор по документам, подходящим под часть запроса, по возрастанию номера.
+// advance(target) ничего не делает, если текущий документ уже >= target.
+class DocumentIterator {
+public:
+    virtual ~DocumentIterator() = default;
+
+    std::uint32_t document() const { return document_; }
+    bool at_end() const { return document_ == kEnd; }
+
+    virtual void next() = 0;
+    virtual void advance(std::uint32_t target) = 0;
+    // BM25 текущего документа
+    virtual float score() = 0;
+    // Верхняя граница оценки любого документа
+    virtual float max_score() const = 0;
+    // Верхняя граница оценки документов от target до block_end включительно
+    virtual float block_max_score(std::uint32_t target, std::uint32_t& block_end) = 0;
+    // Сколько документов может выдать итератор (для порядка пересечения)
+    virtual std::size_t cost() const = 0;
+
+protected:
+    std::uint32_t document_ = kEnd;
+};
+
+using IteratorPtr = std::unique_ptr<DocumentIterator>;
+
+class TermIterator : public DocumentIterator {
+public:
+    explicit TermIterator(Cursor cursor) : cursor_(std::move(cursor)) { document_ = cursor_.document(); }
+
+    void next() override {
+        cursor_.next();
+        document_ = cursor_.document();
+    }
+
+    void advance(std::uint32_t target) override {
+        cursor_.advance(target);
+        document_ = cursor_.document();
+    }
+
+    float score() override { return cursor_.score(); }
+    float max_score() const override { return cursor_.max_score(); }
+
+    float block_max_score(std::uint32_t target, std::uint32_t& block_end) override {
+        const InvertedIndex::Block* block = cursor_.seek_block(target);
+        if (!block) {
+            block_end = kEnd;
+            return 0;
+        }
+        block_end = block->last_document;
+        return cursor_.block_max_score(*block);
+    }
+
+    std::size_t cost() const override { return cursor_.size(); }
+
+    void positions(std::vector<std::uint32_t>& out) { cursor_.positions(out); }
+
+private:
+    Cursor cursor_;
+};
+
+// Пересечение: кандидата предлагает самый короткий список, остальные
+// догоняют его через advance (пропуская блоки целиком); кто перескочил -
+// предлагает нового кандидата. Документы исключаемых списков отбрасываются.
+class AndIterator : public DocumentIterator {
+public:
+    AndIterator(std::vector<IteratorPtr> required, std::vector<IteratorPtr> excluded)
+        : required_(std::move(required)), excluded_(std::move(excluded)) {
+        std::sort(required_.begin(), required_.end(),
+            [](const IteratorPtr& a, const IteratorPtr& b) { return a->cost() < b->cost(); });
+        settle(required_.front()->document());
+    }
+
+    void next() override {
+        if (at_end()) {
+            return;
+        }
+        required_.front()->next();
+        settle(required_.front()->document());
+    }
+
+    void advance(std::uint32_t target) override {
+        if (at_end() || document_ >= target) {
+            return;
+        }
+        required_.front()->advance(target);
+        settle(required_.front()->document());
+    }
+
+    float score() override {
+        float score = 0;
+        for (auto& iterator : required_) {
+            score += iterator->score();
+        }
+        return score;
+    }
+
+    float max_score() const override {
+        float bound = 0;
+        for (const auto& iterator : required_) {
+            bound += iterator->max_score();
+        }
+        return bound;
+    }
+
+    float block_max_score(std::uint32_t target, std::uint32_t& block_end) override {
+        float bound = 0;
+        block_end = kEnd;
+        for (auto& iterator : required_) {
+            std::uint32_t end;
+            bound += iterator->block_max_score(target, end);
+            block_end = std::min(block_end, end);
+        }
+        return bound;
+    }
+
+    std::size_t cost() const override { return required_.front()->cost(); }
+
+private:
+    void settle(std::uint32_t candidate) {
+        while (candidate != kEnd) {
+            bool agreed = true;
+            for (auto& iterator : required_) {
+                iterator->advance(candidate);
+                if (iterator->document() != candidate) {
+                    candidate = iterator->document();
+                    agreed = false;
+                    break;
+                }
+            }
+            if (!agreed) {
+                continue;
+            }
+            bool rejected = false;
+            for (auto& iterator : excluded_) {
+                iterator->advance(candidate);
+                if (iterator->document() == candidate) {
+                    rejected = true;
+                    break;
+                }
+            }
+            if (!rejected) {
+                document_ = candidate;
+                return;
+            }
+            required_.front()->next();
+            candidate = required_.front()->document();
+        }
+        document_ = kEnd;
+    }
+
+    std::vector<IteratorPtr> required_;
+    std::vector<IteratorPtr> excluded_;
+};
+
+// Объединение: текущий документ - наименьший среди частей
+class OrIterator : public DocumentIterator {
+public:
+    explicit OrIterator(std::vector<IteratorPtr> parts) : parts_(std::move(parts)) { settle(); }
+
+    void next() override {
+        std::uint32_t const current = document_;
+        for (auto& part : parts_) {
+            if (part->document() == current) {
+                part->next();
+            }
+        }
+        settle();
+    }
+
+    void advance(std::uint32_t target) override {
+        if (at_end() || document_ >= target) {
+            return;
+        }
+        for (auto& part : parts_) {
+            part->advance(target);
+        }
+        settle();
+    }
+
+    float score() override {
+        float score = 0;
+        for (auto& part : parts_) {
+            if (part->document() == document_) {
+                score += part->score();
+            }
+        }
+        return score;
+    }
+
+    float max_score() const override {
+        float bound = 0;
+        for (const auto& part : parts_) {
+            bound += part->max_score();
+        }
+        return bound;
+    }
+
+    float block_max_score(std::uint32_t target, std::uint32_t& block_end) override {
+        float bound = 0;
+        block_end = kEnd;
+        for (auto& part : parts_) {
+            std::uint32_t end;
+            bound += part->block_max_score(target, end);
+            block_end = std::min(block_end, end);
+        }
+        return bound;
+    }
+
+    std::size_t cost() const override {
+        std::size_t cost = 0;
+        for (const auto& part : parts_) {
+            cost += part->cost();
+        }
+        return cost;
+    }
+
+private:
+    void settle() {
+        document_ = kEnd;
+        for (const auto& part : parts_) {
+            document_ = std::min(document_, part->document());
+        }
+    }
+
+    std::vector<IteratorPtr> parts_;
+};
+
+// Фраза: документы со всеми словами (пересечение, как у AND), в которых
+// слова стоят подряд. Позиции читаются только у документов, прошедших
+// пересечение, и по одному слову: как только вариантов начала фразы не
+// осталось, остальные слова не распаковываются.
+class PhraseIterator : public DocumentIterator {
+public:
+    PhraseIterator(const std::vector<QueryNode>& words, const InvertedIndex& index, TopKStats& stats)
+        : stats_(stats), positions_(words.size()) {
+        std::vector<IteratorPtr> required;
+        for (const auto& word : words) {
+            auto iterator = std::make_unique<TermIterator>(index.postings(word.term));
+            words_.push_back(iterator.get());
+            offsets_.push_back(word.offset);
+            required.push_back(std::move(iterator));
+        }
+        all_ = std::make_unique<AndIterator>(std::move(required), std::vector<IteratorPtr>());
+        settle();
+    }
+
+    void next() override {
+        all_->next();
+        settle();
+    }
+
+    void advance(std::uint32_t target) override {
+        if (at_end() || document_ >= target) {
+            return;
+        }
+        all_->advance(target);
+        settle();
+    }
+
+    float score() override { return all_->score(); }
+    float max_score() const override { return all_->max_score(); }
+
+    float block_max_score(std::uint32_t target, std::uint32_t& block_end) override {
+        return all_->block_max_score(target, block_end);
+    }
+
+    std::size_t cost() const override { return all_->cost(); }
+
+private:
+    void settle() {
+        while (!all_->at_end() && !contains_phrase()) {
+            all_->next();
+        }
+        document_ = all_->document();
+    }
+
+    bool contains_phrase() {
+        stats_.positioned++;
+        // starts_ - позиции, с которых может начинаться фраза
+        words_[0]->positions(starts_);
+        for (std::size_t i = 1; i < words_.size() && !starts_.empty(); ++i) {
+            std::vector<std::uint32_t>& positions = positions_[i];
+            words_[i]->positions(positions);
+            std::uint32_t const offset = offsets_[i];
+            starts_.erase(std::remove_if(starts_.begin(), starts_.end(), [&](std::uint32_t start) {
+                return !std::binary_search(positions.begin(), positions.end(), start + offset);
+                }), starts_.end());
+        }
+        return !starts_.empty();
+    }
+
+    TopKStats& stats_;
+    std::vector<TermIterator*> words_; // В порядке фразы; владеет ими all_
+    std::vector<std::uint32_t> offsets_; // Номер слова от начала фразы, с учетом выброшенных
+    std::unique_ptr<AndIterator> all_;
+    std::vector<std::uint32_t> starts_;
+    std::vector<std::vector<std::uint32_t>> positions_;
+};
+
+IteratorPtr build(const QueryNode& node, const InvertedIndex& index, TopKStats& stats);
+
+// Части AND или OR: NOT-части отделяются в excluded
+void build_parts(const QueryNode& node, const InvertedIndex& index, TopKStats& stats, std::vector<IteratorPtr>& parts,
+    std::vector<IteratorPtr>& excluded) {
+    for (const auto& child : node.children) {
+        if (child.kind == QueryNode::Kind::Not) {
+            excluded.push_back(build(child.children.front(), index, stats));
+        }
+        else {
+            parts.push_back(build(child, index, stats));
+        }
+    }
+    if (parts.empty()) {
+        throw std::invalid_argument("NOT must be combined with at least one word that is not negated.");
+    }
+}
+
+IteratorPtr build(const QueryNode& node, const InvertedIndex& index, TopKStats& stats) {
+    switch (node.kind) {
+    case QueryNode::Kind::Term:
+        return std::make_unique<TermIterator>(index.postings(node.term));
+    case QueryNode::Kind::Phrase:
+        return std::make_unique<PhraseIterator>(node.children, index, stats);
+    case QueryNode::Kind::And: {
+        std::vector<IteratorPtr> required;
+        std::vector<IteratorPtr> excluded;
+        build_parts(node, index, stats, required, excluded);
+        return std::make_unique<AndIterator>(std::move(required), std::move(excluded));
+    }
+    case QueryNode::Kind::Or: {
+        // "a b -c" и "a OR NOT c": NOT исключает документы из всего OR
+        std::vector<IteratorPtr> parts;
+        std::vector<IteratorPtr> excluded;
+        build_parts(node, index, stats, parts, excluded);
+        IteratorPtr any = parts.size() == 1 ? std::move(parts.front()) : std::make_unique<OrIterator>(std::move(parts));
+        if (excluded.empty()) {
+            return any;
+        }
+        std::vector<IteratorPtr> required;
+        required.push_back(std::move(any));
+        return std::make_unique<AndIterator>(std::move(required), std::move(excluded));
+    }
+    case QueryNode::Kind::Not:
+    default:
+        throw std::invalid_argument("NOT must be combined with at least one word that is not negated.");
+    }
+}
+
+// Слова запроса вне NOT в порядке запроса, без повторов
+void collect_terms(const QueryNode& node, std::vector<std::string>& terms) {
+    if (node.kind == QueryNode::Kind::Not) {
+        return;
+    }
+    if (node.kind == QueryNode::Kind::Term) {
+        if (std::find(terms.begin(), terms.end(), node.term) == terms.end()) {
+            terms.push_back(node.term);
+        }
+        return;
+    }
+    for (const auto& child : node.children) {
+        collect_terms(child, terms);
+    }
+}
+
+bool is_disjunction_of_terms(const QueryNode& query) {
+    if (query.kind == QueryNode::Kind::Term) {
+        return true;
+    }
+    return query.kind == QueryNode::Kind::Or && std::all_of(query.children.begin(), query.children.end(),
+        [](const QueryNode& child) { return child.kind == QueryNode::Kind::Term; });
+}
+
+} // namespace
+
+std::vector<ScoredDocument> evaluate_query(const QueryNode& query, const InvertedIndex& index, std::size_t k,
+    TopKStats& stats) {
+    if (is_disjunction_of_terms(query)) {
+        std::vector<Cursor> cursors;
+        if (query.kind == QueryNode::Kind::Term) {
+            cursors.push_back(index.postings(query.term));
+        }
+        for (const auto& child : query.children) {
+            cursors.push_back(index.postings(child.term));
+        }
+        return top_k(cursors, k, stats);
+    }
+
+    IteratorPtr root = build(query, index, stats);
+    ResultHeap heap(k);
+    while (!root->at_end() && k > 0) {
+        float const threshold = heap.threshold();
+        if (heap.full()) {
+            // Ни один оставшийся документ не войдет в k лучших
+            if (root->max_score() <= threshold) {
+                break;
+            }
+            std::uint32_t block_end;
+            if (root->block_max_score(root->document(), block_end) <= threshold) {
+                stats.skipped++;
+                if (block_end == kEnd) {
+                    break;
+                }
+                root->advance(block_end + 1);
+                continue;
+            }
+        }
+        stats.scored++;
+        heap.push(root->document(), root->score());
+        root->next();
+    }
+    return heap.take();
+}
+
+void rerank_by_proximity(const QueryNode& query, const InvertedIndex& index, std::vector<ScoredDocument>& results,
+    TopKStats& stats) {
+    std::vector<std::string> terms;
+    collect_terms(query, terms);
+    if (terms.size() < 2 || results.empty()) {
+        return;
+    }
+
+    // Курсоры двигаются только вперед: кандидаты обходятся по номерам документов
+    std::vector<std::size_t> order(results.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+        [&](std::size_t a, std::size_t b) { return results[a].document < results[b].document; });
+
+    std::vector<Cursor> cursors;
+    for (const auto& term : terms) {
+        cursors.push_back(index.postings(term));
+    }
+    std::vector<std::uint32_t> positions;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> occurrences; // (позиция, слово)
+    std::vector<float> accumulators(terms.size());
+    for (std::size_t i : order) {
+        std::uint32_t const document = results[i].document;
+        occurrences.clear();
+        for (std::uint32_t term = 0; term < cursors.size(); ++term) {
+            cursors[term].advance(document);
+            if (cursors[term].document() != document) {
+                continue;
+            }
+            cursors[term].positions(positions);
+            for (std::uint32_t position : positions) {
+                occurrences.emplace_back(position, term);
+            }
+        }
+        stats.positioned++;
+        std::sort(occurrences.begin(), occurrences.end());
+
+        // Соседние вхождения разных слов на расстоянии d добавляют каждому
+        // idf другого слова / d^2; сумма насыщается как частота в BM25
+        std::fill(accumulators.begin(), accumulators.end(), 0.0f);
+        for (std::size_t j = 1; j < occurrences.size(); ++j) {
+            auto const [position, term] = occurrences[j];
+            auto const [previous_position, previous_term] = occurrences[j - 1];
+            if (term == previous_term) {
+                continue;
+            }
+            float const distance = static_cast<float>(position - previous_position);
+            accumulators[term] += cursors[previous_term].idf() / (distance * distance);
+            accumulators[previous_term] += cursors[term].idf() / (distance * distance);
+        }
+        for (std::size_t term = 0; term < terms.size(); ++term) {
+            if (accumulators[term] > 0) {
+                results[i].score += std::min(1.0f, cursors[term].idf()) * index.weight(accumulators[term], document);
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end(), [](const ScoredDocument& a, const ScoredDocument& b) {
+        return a.score > b.score || (a.score == b.score && a.document < b.document);
+        });
+}
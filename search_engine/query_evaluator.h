@@ -0,0 +1,37 @@
+#ifndef QUERY_EVALUATOR_H
+#define QUERY_EVALUATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "inverted_index.h"
+#include "query_parser.h"
+#include "top_k.h"
+
+// k лучших по BM25 документов, подходящих под запрос, по убыванию оценки.
+// Оценка - сумма BM25 слов запроса, не стоящих под NOT.
+//
+// Запрос из одних слов через OR считается Block-Max WAND (top_k.h). Для
+// остальных строится дерево итераторов: AND пересекает списки, начиная с
+// самого короткого, и перескакивает к кандидату через данные пропуска блоков;
+// NOT исключает документы из AND, в который входит (внутри OR - из всего OR).
+// Как только куча заполнена, документы из блоков, граница которых не выше
+// k-й оценки, пропускаются, а обход заканчивается, когда не выше нее граница
+// всего запроса.
+//
+// Фраза пересекается как AND, после чего у оставшихся документов читаются
+// позиции слов; ее оценка - сумма BM25 ее слов.
+//
+// Бросает std::invalid_argument, если в запросе нет слов без NOT.
+std::vector<ScoredDocument> evaluate_query(const QueryNode& query, const InvertedIndex& index, std::size_t k,
+    TopKStats& stats);
+
+// Режим близости: добавляет к оценкам results слагаемое за близость слов
+// запроса на странице (BM25TP, Buttcher и др., 2006) и сортирует заново. Соседние
+// вхождения разных слов на расстоянии d дают каждому из них idf другого
+// слова / d^2, накопленное насыщается как частота в BM25. Позиции читаются
+// только у переданных документов, поэтому переоценивается лучшая часть
+// выдачи BM25, а не все совпадения.
+void rerank_by_proximity(const QueryNode& query, const InvertedIndex& index, std::vector<ScoredDocument>& results,
+    TopKStats& stats);
+
+#endif // QUERY_EVALUATOR_H
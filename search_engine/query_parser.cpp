@@ -0,0 +1,241 @@
+#include "query_parser.h"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include "../spider/tokenizer.h"
+
+namespace {
+
+struct Token {
+    enum class Type { Word, Phrase, And, Or, Not, Open, Close, End };
+
+    Type type = Type::End;
+    std::string_view text;
+};
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool is_delimiter(char c) {
+    return is_space(c) || c == '(' || c == ')' || c == '"';
+}
+
+std::vector<Token> lex(std::string_view text) {
+    std::vector<Token> tokens;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        char const c = text[i];
+        if (is_space(c)) {
+            i++;
+        }
+        else if (c == '"') {
+            // Незакрытая кавычка продолжается до конца запроса
+            std::size_t const end = std::min(text.find('"', i + 1), text.size());
+            tokens.push_back({ Token::Type::Phrase, text.substr(i + 1, end - i - 1) });
+            i = end + 1;
+        }
+        else if (c == '(' || c == ')') {
+            tokens.push_back({ c == '(' ? Token::Type::Open : Token::Type::Close, text.substr(i, 1) });
+            i++;
+        }
+        else if (c == '-' && i + 1 < text.size() && (!is_delimiter(text[i + 1]) || text[i + 1] == '"' || text[i + 1] == '(')) {
+            tokens.push_back({ Token::Type::Not, text.substr(i, 1) });
+            i++;
+        }
+        else {
+            std::size_t end = i;
+            while (end < text.size() && !is_delimiter(text[end])) {
+                end++;
+            }
+            std::string_view const word = text.substr(i, end - i);
+            Token::Type type = Token::Type::Word;
+            if (word == "AND") {
+                type = Token::Type::And;
+            }
+            else if (word == "OR") {
+                type = Token::Type::Or;
+            }
+            else if (word == "NOT") {
+                type = Token::Type::Not;
+            }
+            tokens.push_back({ type, word });
+            i = end;
+        }
+    }
+    tokens.push_back({ Token::Type::End, {} });
+    return tokens;
+}
+
+// Узел из непустых частей: вложенные узлы того же вида раскрываются,
+// единственная часть возвращается как есть
+std::optional<QueryNode> combine(QueryNode::Kind kind, std::vector<std::optional<QueryNode>>& parts) {
+    QueryNode node;
+    node.kind = kind;
+    for (auto& part : parts) {
+        if (!part) {
+            continue;
+        }
+        if (part->kind == kind) {
+            for (auto& child : part->children) {
+                node.children.push_back(std::move(child));
+            }
+        }
+        else {
+            node.children.push_back(std::move(*part));
+        }
+    }
+    if (node.children.empty()) {
+        return std::nullopt;
+    }
+    if (node.children.size() == 1) {
+        return std::move(node.children.front());
+    }
+    return node;
+}
+
+// Рекурсивный спуск; пустой результат - в выражении не осталось слов.
+// Глубина скобок и NOT ограничена: запрос приходит от клиента, а разбор,
+// вычисление и разрушение дерева рекурсивны.
+class Parser {
+public:
+    explicit Parser(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
+
+    std::optional<QueryNode> parse() {
+        std::optional<QueryNode> query = parse_or();
+        if (peek() != Token::Type::End) {
+            throw std::invalid_argument("Unexpected ')' in query.");
+        }
+        return query;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    Token::Type peek() const { return tokens_[position_].type; }
+
+    void enter() {
+        if (++depth_ > kMaxDepth) {
+            throw std::invalid_argument("Query is nested too deeply.");
+        }
+    }
+
+    std::optional<QueryNode> parse_or() {
+        std::vector<std::optional<QueryNode>> parts;
+        parts.push_back(parse_and());
+        while (peek() != Token::Type::End && peek() != Token::Type::Close) {
+            if (peek() == Token::Type::Or) {
+                position_++;
+            }
+            parts.push_back(parse_and());
+        }
+        return combine(QueryNode::Kind::Or, parts);
+    }
+
+    std::optional<QueryNode> parse_and() {
+        std::vector<std::optional<QueryNode>> parts;
+        parts.push_back(parse_unary());
+        while (peek() == Token::Type::And) {
+            position_++;
+            parts.push_back(parse_unary());
+        }
+        return combine(QueryNode::Kind::And, parts);
+    }
+
+    std::optional<QueryNode> parse_unary() {
+        if (peek() != Token::Type::Not) {
+            return parse_primary();
+        }
+        position_++;
+        enter();
+        std::optional<QueryNode> child = parse_unary();
+        depth_--;
+        if (!child) {
+            return std::nullopt;
+        }
+        QueryNode node;
+        node.kind = QueryNode::Kind::Not;
+        node.children.push_back(std::move(*child));
+        return node;
+    }
+
+    std::optional<QueryNode> parse_primary() {
+        const Token& token = tokens_[position_];
+        switch (token.type) {
+        case Token::Type::Open: {
+            position_++;
+            enter();
+            std::optional<QueryNode> inner = parse_or();
+            if (peek() != Token::Type::Close) {
+                throw std::invalid_argument("Missing ')' in query.");
+            }
+            depth_--;
+            position_++;
+            return inner;
+        }
+        case Token::Type::Word:
+            position_++;
+            return parse_word(token.text);
+        case Token::Type::Phrase:
+            position_++;
+            return parse_phrase(token.text);
+        case Token::Type::End:
+            throw std::invalid_argument("Query ends where a word is expected.");
+        default:
+            throw std::invalid_argument("Unexpected '" + std::string(token.text) + "' in query.");
+        }
+    }
+
+    // Слово приводится к виду индекса тем же токенизатором, что и страницы
+    static std::optional<QueryNode> parse_word(std::string_view word) {
+        std::string text(word);
+        std::vector<std::string_view> terms;
+        split_terms(text.data(), text.size(), terms);
+        std::vector<std::optional<QueryNode>> parts;
+        for (std::string_view term : terms) {
+            QueryNode node;
+            node.term = std::string(term);
+            parts.push_back(std::move(node));
+        }
+        return combine(QueryNode::Kind::And, parts);
+    }
+
+    // Слова фразы в порядке текста; операторы внутри кавычек - обычные слова.
+    // Короткие слова выбрасываются, но место в фразе за ними остается
+    static std::optional<QueryNode> parse_phrase(std::string_view phrase) {
+        std::string text(phrase);
+        std::vector<std::string_view> terms;
+        std::vector<std::uint32_t> positions;
+        split_terms(text.data(), text.size(), terms, positions);
+        QueryNode node;
+        if (terms.size() < 2) {
+            if (terms.empty()) {
+                return std::nullopt;
+            }
+            node.term = std::string(terms.front());
+            return node;
+        }
+        node.kind = QueryNode::Kind::Phrase;
+        for (std::size_t i = 0; i < terms.size(); ++i) {
+            QueryNode word;
+            word.term = std::string(terms[i]);
+            word.offset = positions[i] - positions.front();
+            node.children.push_back(std::move(word));
+        }
+        return node;
+    }
+
+    std::vector<Token> tokens_;
+    std::size_t position_ = 0;
+    int depth_ = 0;
+};
+
+} // namespace
+
+QueryNode parse_query(std::string_view text) {
+    std::optional<QueryNode> query = Parser(lex(text)).parse();
+    if (!query) {
+        throw std::invalid_argument("Query must contain at least one word of three or more letters.");
+    }
+    return std::move(*query);
+}
@@ -0,0 +1,32 @@
+#ifndef QUERY_PARSER_H
+#define QUERY_PARSER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Разобранный запрос. Слова уже приведены к виду индекса (tokenizer.h).
+struct QueryNode {
+    enum class Kind { Term, And, Or, Not, Phrase };
+
+    Kind kind = Kind::Term;
+    std::string term;               // Для Term
+    std::uint32_t offset = 0;       // У слова фразы - его номер от начала фразы
+    std::vector<QueryNode> children; // У Phrase - слова фразы по порядку
+};
+
+// Язык запросов:
+//   слова через пробел      - любое из слов (OR), как раньше
+//   a AND b, a OR b, NOT a  - операторы заглавными буквами; NOT сильнее AND, AND сильнее OR
+//   -a                      - то же, что NOT a
+//   "a b c"                 - фраза: слова подряд в этом порядке
+//   ( ... )                 - группировка
+// Слово, которое токенизатор делит на части ("e-mail"), становится AND частей.
+// Слова короче трех букв не индексируются и из запроса выбрасываются; во фразе
+// за ними остается место: "end of war" ищет end и war через одно слово.
+// При синтаксической ошибке, пустом запросе или вложенности скобок и NOT
+// глубже 64 бросает std::invalid_argument.
+QueryNode parse_query(std::string_view text);
+
+#endif // QUERY_PARSER_H
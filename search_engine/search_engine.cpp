@@ -11,6 +11,11 @@
 #include <cctype>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "query_evaluator.h"
+#include "query_parser.h"
 
 namespace beast = boost::beast;
 namespace http = boost::beast::http;
@@ -18,33 +23,130 @@ namespace net = boost::asio;
 namespace ssl = boost::asio::ssl;
 using tcp = boost::asio::ip::tcp;
 
+namespace {
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Декодирует значение поля формы application/x-www-form-urlencoded
+std::string decode_form_value(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '+') {
+            result += ' ';
+        }
+        else if (value[i] == '%' && i + 2 < value.size() && hex_value(value[i + 1]) >= 0 && hex_value(value[i + 2]) >= 0) {
+            result += static_cast<char>(hex_value(value[i + 1]) * 16 + hex_value(value[i + 2]));
+            i += 2;
+        }
+        else {
+            result += value[i];
+        }
+    }
+    return result;
+}
+
+// Значение поля формы или пустая строка, если поля нет
+std::string form_field(std::string_view body, std::string_view name) {
+    while (!body.empty()) {
+        std::size_t const end = std::min(body.find('&'), body.size());
+        std::string_view const field = body.substr(0, end);
+        if (field.size() > name.size() && field.substr(0, name.size()) == name && field[name.size()] == '=') {
+            return decode_form_value(field.substr(name.size() + 1));
+        }
+        body.remove_prefix(std::min(end + 1, body.size()));
+    }
+    return {};
+}
+
+std::string html_escape(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '&': result += "&amp;"; break;
+        case '<': result += "&lt;"; break;
+        case '>': result += "&gt;"; break;
+        case '"': result += "&quot;"; break;
+        case '\'': result += "&#39;"; break;
+        default: result += c;
+        }
+    }
+    return result;
+}
+
+// Кнопка перехода на другую страницу результатов того же запроса
+std::string page_form(const std::string& query, int page, int size, bool proximity, const char* label) {
+    return "<form action=\"/\" method=\"post\" style=\"display:inline\">"
+        "<input type=\"hidden\" name=\"query\" value=\"" + html_escape(query) + "\" />"
+        "<input type=\"hidden\" name=\"page\" value=\"" + std::to_string(page) + "\" />"
+        "<input type=\"hidden\" name=\"size\" value=\"" + std::to_string(size) + "\" />" +
+        (proximity ? "<input type=\"hidden\" name=\"proximity\" value=\"1\" />" : "") +
+        "<button type=\"submit\">" + label + "</button></form>";
+}
+
+} // namespace
 
 SearchEngine::SearchEngine(const Config& config)
     : ioc_(),
     acceptor_(ioc_, tcp::endpoint{ net::ip::make_address("0.0.0.0"), static_cast<unsigned short>(config.server_port) }),
     ctx_(ssl::context::tlsv12),
-    conn_("host=" + config.db_host +
-        " port=" + std::to_string(config.db_port) +
-        " dbname=" + config.db_name +
-        " user=" + config.db_user +
-        " password=" + config.db_password),
+    index_(config),
+    search_results_(std::max(1, config.search_results)),
+    thread_count_(config.server_threads > 0 ? config.server_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))),
     port_(std::to_string(config.server_port)),
     host_("0.0.0.0") {
     ctx_.set_default_verify_paths();
     ctx_.set_options(ssl::context::default_workarounds |
         ssl::context::no_sslv2 |
         ssl::context::no_sslv3);
+
+    // Одно соединение на время загрузки: после нее сервер к базе не обращается
+    std::cout << "Loading inverted index..." << std::endl;
+    {
+        pqxx::connection conn(DatabasePool::connection_options(config));
+        index_.load(conn);
+    }
+    const InvertedIndex::Stats& stats = index_.stats();
+    std::cout << "Inverted index: " << stats.documents << " documents, " << stats.terms << " terms, "
+        << stats.postings << " postings loaded in " << stats.seconds << " s, "
+        << stats.bytes / (1024.0 * 1024.0) << " MiB (" << stats.raw_bytes / (1024.0 * 1024.0)
+        << " MiB uncompressed postings, " << stats.position_bytes / (1024.0 * 1024.0) << " MiB positions), "
+        << posting_decoder_name() << " decoder" << std::endl;
 }
 
 void SearchEngine::start() {
     std::cout << "Starting server..." << std::endl;
     do_accept();
-    std::cout << "Running I/O context..." << std::endl;
+    std::cout << "Running I/O context on " << thread_count_ << " threads..." << std::endl;
+
+    // Запросы считаются по индексу в памяти и занимают процессор, поэтому
+    // io_context крутят несколько потоков, по умолчанию по числу ядер
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count_ - 1);
+    for (int i = 1; i < thread_count_; ++i) {
+        threads.emplace_back([this]() {
+            try {
+                ioc_.run();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Exception in server thread: " << e.what() << std::endl;
+            }
+            });
+    }
     ioc_.run();
+    for (auto& thread : threads) {
+        thread.join();
+    }
 }
 
 void SearchEngine::do_accept() {
-    std::cout << "Waiting for connections on port " << port_ << "..." << std::endl; //  
+    std::cout << "Waiting for connections on port " << port_ << "..." << std::endl; // Отладочный вывод
     acceptor_.async_accept(
         net::make_strand(ioc_),
         beast::bind_front_handler(
@@ -57,7 +159,7 @@ void SearchEngine::on_accept(beast::error_code ec, tcp::socket socket) {
         std::cerr << "Error during accept: " << ec.message() << std::endl;
         return;
     }
-    std::cout << "New connection accepted." << std::endl; //  
+    std::cout << "New connection accepted." << std::endl; // Отладочный вывод
     auto session = std::make_shared<Session>(std::move(socket), *this);
     session->run();
     do_accept();
@@ -75,6 +177,7 @@ void SearchEngine::handle_get_request(const http::request<http::string_body>& re
         <form action="/" method="post">
             <input type="text" name="query" />
             <button type="submit">Search</button>
+            <label><input type="checkbox" name="proximity" value="1" /> Rank pages with the words close together higher</label>
         </form>
     </body>
     </html>
@@ -91,98 +194,102 @@ void SearchEngine::handle_get_request(const http::request<http::string_body>& re
 }
 
 void SearchEngine::handle_post_request(const http::request<http::string_body>& req, std::shared_ptr<Session> session) {
-    std::string query = req.body();
-
-    //    
-    std::transform(query.begin(), query.end(), query.begin(), ::tolower);
-
-    //  "query="   ,  
-    if (query.rfind("query=", 0) == 0) {
-        query = query.substr(6);
+    std::string_view const body = req.body();
+    std::string const query = form_field(body, "query");
+    if (query.size() > kMaxQueryLength) {
+        session->handle_error(http::status::bad_request, "Query is too long.");
+        return;
     }
+    bool const proximity = !form_field(body, "proximity").empty();
 
-    //   '+'  
-    std::replace(query.begin(), query.end(), '+', ' ');
-
-    //     
-    boost::algorithm::trim(query);
-
-    // ,    
-    if (query.empty()) {
-        session->handle_error(http::status::bad_request, "Invalid or empty query.");
+    // Номер страницы с 1 и размер страницы; k лучших ищутся с запасом в
+    // один документ, чтобы знать, есть ли следующая страница
+    int page = 1;
+    int size = search_results_;
+    try {
+        std::string const page_field = form_field(body, "page");
+        std::string const size_field = form_field(body, "size");
+        if (!page_field.empty()) {
+            page = std::stoi(page_field);
+        }
+        if (!size_field.empty()) {
+            size = std::stoi(size_field);
+        }
+    }
+    catch (const std::exception&) {
+        session->handle_error(http::status::bad_request, "Invalid page or size.");
         return;
     }
-
-    //       boost
-    std::vector<std::string> words;
-    boost::split(words, query, boost::is_any_of(" "), boost::token_compress_on);
-
-    if (words.empty()) {
-        session->handle_error(http::status::bad_request, "Query must contain at least one word.");
+    if (page < 1 || size < 1 || size > kMaxPageSize || page > kMaxResultDepth / size) {
+        session->handle_error(http::status::bad_request, "Page or size is out of range.");
         return;
     }
+    std::size_t const first = static_cast<std::size_t>(page - 1) * size;
 
+    auto const started = std::chrono::steady_clock::now();
+    std::vector<ScoredDocument> matches;
+    TopKStats top_stats;
     try {
-        //  search_path   'search_engine'
-        pqxx::work txn_set_schema(conn_);
-        txn_set_schema.exec("SET search_path TO search_engine");
-        txn_set_schema.commit();
-
-        pqxx::work txn(conn_);
-
-        //  SQL-
-        std::string sql = "SELECT d.url, SUM(wf.frequency) AS total_frequency "
-            "FROM documents d "
-            "JOIN word_frequencies wf ON d.id = wf.document_id "
-            "JOIN words w ON wf.word_id = w.id "
-            "WHERE LOWER(w.word) IN (";
-
-        //    SQL-
-        for (std::size_t i = 0; i < words.size(); ++i) {
-            if (i > 0) sql += ",";
-            sql += txn.quote(words[i]);
-        }
-        sql += ") GROUP BY d.url ORDER BY total_frequency DESC;";
-
-        std::cout << "Executing SQL query: " << sql << std::endl;
-
-        //  SQL-
-        pqxx::result res = txn.exec(sql);
-        txn.commit();
-
-        std::cout << "Query executed. Number of rows returned: " << res.size() << std::endl;
-
-        //  HTML 
-        std::string html = "<!DOCTYPE html><html><head><title>Search Results</title></head><body><h1>Search Results</h1>";
-
-        if (res.empty()) {
-            html += "<p>No results found.</p>";
+        QueryNode const parsed = parse_query(query);
+        if (proximity) {
+            // Переоценивается не меньше kProximityCandidates лучших по BM25,
+            // чтобы первые страницы не зависели от того, какая из них открыта
+            matches = evaluate_query(parsed, index_, std::max<std::size_t>(first + size + 1, kProximityCandidates), top_stats);
+            rerank_by_proximity(parsed, index_, matches, top_stats);
         }
         else {
-            html += "<table border='1'><thead><tr><th>URL</th><th>Total Frequency</th></tr></thead><tbody>";
-            for (const auto& row : res) {
-                std::string url = row["url"].c_str();
-                std::string total_frequency = row["total_frequency"].c_str();
-                html += "<tr><td><a href=\"" + url + "\">" + url + "</a></td><td>" + total_frequency + "</td></tr>";
-            }
-            html += "</tbody></table>";
+            matches = evaluate_query(parsed, index_, first + size + 1, top_stats);
         }
+    }
+    catch (const std::invalid_argument& e) {
+        session->handle_error(http::status::bad_request, e.what());
+        return;
+    }
+    auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    bool const has_next = matches.size() > first + size;
 
-        html += "</body></html>";
+    std::cout << "Query answered from memory: page " << page << " of size " << size << ", "
+        << matches.size() << " results, " << top_stats.scored << " documents scored, "
+        << top_stats.skipped << " block skips, " << top_stats.positioned << " documents with positions read, "
+        << elapsed << " ms" << std::endl;
 
-        http::response<http::string_body> response{ http::status::ok, req.version() };
-        response.set(http::field::server, "SearchEngine");
-        response.set(http::field::content_type, "text/html");
-        response.content_length(html.size());
-        response.body() = html;
-        response.prepare_payload();
+    // Формирование HTML ответа: только запрошенная страница
+    std::string html = "<!DOCTYPE html><html><head><title>Search Results</title></head><body><h1>Search Results</h1>";
 
-        session->send_response(response);
+    if (matches.size() <= first) {
+        html += "<p>No results found.</p>";
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error executing SQL query: " << e.what() << std::endl;
-        session->handle_error(http::status::internal_server_error, "Database query failed");
+    else {
+        html += "<table border='1'><thead><tr><th>#</th><th>URL</th><th>Score</th></tr></thead><tbody>";
+        std::size_t const last = std::min(matches.size(), first + size);
+        for (std::size_t i = first; i < last; ++i) {
+            std::string const url = html_escape(index_.url(matches[i].document));
+            char score[32];
+            std::snprintf(score, sizeof(score), "%.3f", matches[i].score);
+            html += "<tr><td>" + std::to_string(i + 1) + "</td><td><a href=\"" + url + "\">" + url + "</a></td><td>";
+            html += score;
+            html += "</td></tr>";
+        }
+        html += "</tbody></table>";
     }
+
+    if (page > 1) {
+        html += page_form(query, page - 1, size, proximity, "Previous");
+    }
+    if (has_next) {
+        html += page_form(query, page + 1, size, proximity, "Next");
+    }
+
+    html += "</body></html>";
+
+    http::response<http::string_body> response{ http::status::ok, req.version() };
+    response.set(http::field::server, "SearchEngine");
+    response.set(http::field::content_type, "text/html");
+    response.content_length(html.size());
+    response.body() = html;
+    response.prepare_payload();
+
+    session->send_response(response);
 }
 
 Session::Session(tcp::socket socket, SearchEngine& search_engine)
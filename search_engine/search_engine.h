@@ -6,7 +6,11 @@
 #include <boost/asio/ssl.hpp>
 #include <pqxx/pqxx>
 #include "../config/config.h"
+#include "../database/database_pool.h"
+#include "inverted_index.h"
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace beast = boost::beast;
 namespace http = boost::beast::http;
@@ -16,7 +20,7 @@ using tcp = boost::asio::ip::tcp;
 
 class SearchEngine;
 
-//  Session   HTTP-
+// Класс Session для обработки HTTP-сессий
 class Session : public std::enable_shared_from_this<Session> {
 public:
     Session(tcp::socket socket, SearchEngine& search_engine);
@@ -52,10 +56,17 @@ private:
     void do_accept();
     void on_accept(beast::error_code ec, tcp::socket socket);
 
+    static constexpr std::size_t kMaxQueryLength = 1024;
+    static constexpr int kMaxPageSize = 100;
+    static constexpr int kMaxResultDepth = 1000; // Дальше этой позиции страницы не листаются
+    static constexpr std::size_t kProximityCandidates = 200;
+
     net::io_context ioc_;
     tcp::acceptor acceptor_;
     ssl::context ctx_;
-    pqxx::connection conn_;
+    InvertedIndex index_; // Запросы обслуживаются отсюда, база нужна только для загрузки
+    int search_results_;
+    int thread_count_;
     std::string host_;
     std::string port_;
 };
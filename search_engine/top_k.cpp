@@ -0,0 +1,127 @@
+#include "top_k.h"
+#include <algorithm>
+
+namespace {
+
+using Cursor = InvertedIndex::Cursor;
+
+// Порядок результатов: по убыванию оценки, при равных - по номеру документа
+bool better(const ScoredDocument& a, const ScoredDocument& b) {
+    return a.score > b.score || (a.score == b.score && a.document < b.document);
+}
+
+} // namespace
+
+void ResultHeap::push(std::uint32_t document, float score) {
+    if (k_ == 0) {
+        return;
+    }
+    ScoredDocument const scored{ document, score };
+    if (heap_.size() < k_) {
+        heap_.push_back(scored);
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    }
+    else if (better(scored, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), better);
+        heap_.back() = scored;
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    }
+}
+
+std::vector<ScoredDocument> ResultHeap::take() {
+    std::sort_heap(heap_.begin(), heap_.end(), better);
+    return std::move(heap_);
+}
+
+std::vector<ScoredDocument> top_k(std::vector<Cursor>& cursors, std::size_t k, TopKStats& stats) {
+    ResultHeap heap(k);
+    if (k == 0) {
+        return heap.take();
+    }
+
+    std::vector<Cursor*> live;
+    for (auto& cursor : cursors) {
+        if (!cursor.at_end()) {
+            live.push_back(&cursor);
+        }
+    }
+
+    auto const by_document = [](const Cursor* a, const Cursor* b) { return a->document() < b->document(); };
+    while (true) {
+        // Пока куча не заполнена, порог 0 и оценивается каждый документ
+        float const threshold = heap.threshold();
+        live.erase(std::remove_if(live.begin(), live.end(), [](const Cursor* c) { return c->at_end(); }), live.end());
+        if (live.empty()) {
+            break;
+        }
+        // Слов в запросе немного: сортировка вставками почти упорядоченного массива
+        for (std::size_t i = 1; i < live.size(); ++i) {
+            for (std::size_t j = i; j > 0 && by_document(live[j], live[j - 1]); --j) {
+                std::swap(live[j], live[j - 1]);
+            }
+        }
+
+        // Опорный курсор: первый, на котором сумма границ слов превышает порог.
+        // Документы левее него в k лучших попасть не могут.
+        float bound = 0;
+        std::size_t pivot = live.size();
+        for (std::size_t i = 0; i < live.size(); ++i) {
+            bound += live[i]->max_score();
+            if (bound > threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == live.size()) {
+            break;
+        }
+        std::uint32_t const pivot_document = live[pivot]->document();
+        while (pivot + 1 < live.size() && live[pivot + 1]->document() == pivot_document) {
+            pivot++;
+        }
+
+        // Та же проверка по границам блоков, в которых лежит опорный документ
+        float block_bound = 0;
+        std::uint32_t next_candidate = Cursor::kEnd;
+        for (std::size_t i = 0; i <= pivot; ++i) {
+            const InvertedIndex::Block* block = live[i]->seek_block(pivot_document);
+            if (block) {
+                block_bound += live[i]->block_max_score(*block);
+                next_candidate = std::min(next_candidate, block->last_document + 1);
+            }
+        }
+
+        if (block_bound > threshold) {
+            if (live[0]->document() == pivot_document) {
+                float score = 0;
+                for (Cursor* cursor : live) {
+                    if (cursor->document() != pivot_document) {
+                        break;
+                    }
+                    score += cursor->score();
+                    cursor->next();
+                }
+                stats.scored++;
+                heap.push(pivot_document, score);
+            }
+            else {
+                for (std::size_t i = 0; i < pivot && live[i]->document() < pivot_document; ++i) {
+                    live[i]->advance(pivot_document);
+                }
+            }
+        }
+        else {
+            // До конца текущих блоков (или до следующего слова) ни один
+            // документ не наберет порога - блоки пропускаются без распаковки
+            stats.skipped++;
+            if (pivot + 1 < live.size()) {
+                next_candidate = std::min(next_candidate, live[pivot + 1]->document());
+            }
+            for (std::size_t i = 0; i <= pivot; ++i) {
+                live[i]->advance(next_candidate);
+            }
+        }
+    }
+
+    return heap.take();
+}
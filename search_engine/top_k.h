@@ -0,0 +1,45 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "inverted_index.h"
+
+struct ScoredDocument {
+    std::uint32_t document = 0;
+    float score = 0;
+};
+
+// k лучших документов: наверху кучи худший из них. При равных оценках
+// лучше документ с меньшим номером.
+class ResultHeap {
+public:
+    explicit ResultHeap(std::size_t k) : k_(k) { heap_.reserve(k); }
+
+    bool full() const { return heap_.size() >= k_; }
+    // Оценка, которую нужно превзойти, чтобы попасть в кучу (0, пока она не заполнена)
+    float threshold() const { return full() && !heap_.empty() ? heap_.front().score : 0; }
+
+    void push(std::uint32_t document, float score);
+    // Содержимое по убыванию оценки; куча после этого пуста
+    std::vector<ScoredDocument> take();
+
+private:
+    std::size_t k_;
+    std::vector<ScoredDocument> heap_;
+};
+
+struct TopKStats {
+    std::size_t scored = 0;     // Документов, для которых считался BM25
+    std::size_t skipped = 0;    // Пропусков по границам блоков
+    std::size_t positioned = 0; // Документов, у которых читались позиции слов
+};
+
+// k документов с наибольшей суммой BM25 слов запроса (любое из слов, как OR),
+// по убыванию оценки. Block-Max WAND: документ оценивается, только если сумма
+// верхних границ его слов - сначала по всему списку, затем по блокам - больше
+// k-й лучшей оценки, поэтому работа растет с k, а не с числом совпадений.
+std::vector<ScoredDocument> top_k(std::vector<InvertedIndex::Cursor>& cursors, std::size_t k, TopKStats& stats);
+
+#endif // TOP_K_H
@@ -0,0 +1,90 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Линейный распределитель памяти на время обработки одной страницы.
+// reset() освобождает все сразу, сохраняя блоки для следующей страницы.
+class Arena {
+public:
+    explicit Arena(std::size_t block_size = 256 * 1024) : block_size_(block_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+        std::size_t offset = (align - reinterpret_cast<std::uintptr_t>(cur_) % align) % align;
+        if (!cur_ || offset + size > static_cast<std::size_t>(end_ - cur_)) {
+            next_block(size + align);
+            offset = (align - reinterpret_cast<std::uintptr_t>(cur_) % align) % align;
+        }
+        char* result = cur_ + offset;
+        cur_ = result + size;
+        return result;
+    }
+
+    template <class T>
+    T* allocate_array(std::size_t count) {
+        T* result = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_value_construct_n(result, count);
+        return result;
+    }
+
+    char* copy(std::string_view data) {
+        char* result = static_cast<char*>(allocate(data.size() + 1, 1));
+        std::memcpy(result, data.data(), data.size());
+        result[data.size()] = '\0';
+        return result;
+    }
+
+    void reset() {
+        current_ = 0;
+        cur_ = blocks_.empty() ? nullptr : blocks_[0].data.get();
+        end_ = blocks_.empty() ? nullptr : cur_ + blocks_[0].size;
+    }
+
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.size;
+        }
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    void next_block(std::size_t min_size) {
+        // Повторно используем уже выделенные блоки, если они подходят
+        while (current_ + 1 < blocks_.size()) {
+            ++current_;
+            if (blocks_[current_].size >= min_size) {
+                cur_ = blocks_[current_].data.get();
+                end_ = cur_ + blocks_[current_].size;
+                return;
+            }
+        }
+        std::size_t const size = std::max(block_size_, min_size);
+        blocks_.push_back(Block{ std::unique_ptr<char[]>(new char[size]), size });
+        current_ = blocks_.size() - 1;
+        cur_ = blocks_.back().data.get();
+        end_ = cur_ + size;
+    }
+
+    std::size_t block_size_;
+    std::vector<Block> blocks_;
+    std::size_t current_ = 0;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,492 @@
+#include "charset.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(SEARCH_ENGINE_WITH_SSSE3)
+#include <immintrin.h>
+#define CHARSET_SSSE3 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHARSET_SSE2 1
+#endif
+
+namespace {
+
+// Сколько байт в начале страницы просматривается в поисках <meta> (как в HTML5)
+constexpr std::size_t kMetaPrescanBytes = 1024;
+
+constexpr std::string_view kReplacement = "\xEF\xBF\xBD"; // U+FFFD
+
+// Верхняя половина однобайтовых кодировок (0x80-0xFF); неопределенные байты - U+FFFD
+constexpr std::uint16_t kWindows1251[128] = {
+    0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+    0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+    0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+    0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+    0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+    0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+};
+
+constexpr std::uint16_t kKoi8R[128] = {
+    0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524,
+    0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+    0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248,
+    0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+    0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556,
+    0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+    0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565,
+    0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+    0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433,
+    0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+    0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432,
+    0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+    0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413,
+    0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+    0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412,
+    0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A,
+};
+
+constexpr std::uint16_t kWindows1252[128] = {
+    0x20AC, 0xFFFD, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0xFFFD, 0x017D, 0xFFFD,
+    0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0xFFFD, 0x017E, 0x0178,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+};
+
+// Готовая последовательность UTF-8 для каждого байта: перекодирование -
+// одно обращение к таблице и копирование трех байт на входной байт
+struct Utf8Char {
+    char bytes[3];
+    std::uint8_t size;
+};
+
+using TranscodeTable = std::array<Utf8Char, 256>;
+
+TranscodeTable make_table(const std::uint16_t (&high)[128]) {
+    TranscodeTable table{};
+    for (unsigned b = 0; b < 256; ++b) {
+        std::uint32_t const cp = b < 0x80 ? b : high[b - 0x80];
+        Utf8Char& c = table[b];
+        if (cp < 0x80) {
+            c.bytes[0] = static_cast<char>(cp);
+            c.size = 1;
+        }
+        else if (cp < 0x800) {
+            c.bytes[0] = static_cast<char>(0xC0 | (cp >> 6));
+            c.bytes[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            c.size = 2;
+        }
+        else {
+            c.bytes[0] = static_cast<char>(0xE0 | (cp >> 12));
+            c.bytes[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            c.bytes[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            c.size = 3;
+        }
+    }
+    return table;
+}
+
+const TranscodeTable& transcode_table(Charset charset) {
+    static const TranscodeTable windows1251 = make_table(kWindows1251);
+    static const TranscodeTable koi8r = make_table(kKoi8R);
+    static const TranscodeTable windows1252 = make_table(kWindows1252);
+    switch (charset) {
+    case Charset::Windows1251:
+        return windows1251;
+    case Charset::Koi8R:
+        return koi8r;
+    default:
+        return windows1252;
+    }
+}
+
+void transcode(std::string_view input, const TranscodeTable& table, std::string& out) {
+    out.resize(input.size() * 3);
+    char* dst = out.data();
+    for (unsigned char c : input) {
+        const Utf8Char& u = table[c];
+        std::memcpy(dst, u.bytes, 3);
+        dst += u.size;
+    }
+    out.resize(dst - out.data());
+}
+
+char to_lower_ascii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Значение после "charset" (пробелы, '=', необязательные кавычки) или пустая строка
+std::string_view charset_value(std::string_view text, std::size_t after) {
+    std::size_t pos = text.find_first_not_of(" \t", after);
+    if (pos == std::string_view::npos || text[pos] != '=') {
+        return {};
+    }
+    pos = text.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string_view::npos) {
+        return {};
+    }
+    if (text[pos] == '"' || text[pos] == '\'') {
+        std::size_t const end = text.find(text[pos], pos + 1);
+        return text.substr(pos + 1, end == std::string_view::npos ? std::string_view::npos : end - pos - 1);
+    }
+    std::size_t const end = text.find_first_of(" \t;\"'>/", pos);
+    return text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+}
+
+// Длина корректной последовательности UTF-8 в начале p или 0
+std::size_t utf8_sequence(const unsigned char* p, std::size_t available) {
+    unsigned char const c = p[0];
+    if (c < 0x80) {
+        return 1;
+    }
+    if (c >= 0xC2 && c <= 0xDF) {
+        return available >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (available < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 ||
+            (c == 0xE0 && p[1] < 0xA0) ||   // Overlong
+            (c == 0xED && p[1] >= 0xA0)) {  // Суррогаты
+            return 0;
+        }
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (available < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80 ||
+            (c == 0xF0 && p[1] < 0x90) ||   // Overlong
+            (c == 0xF4 && p[1] >= 0x90)) {  // Больше U+10FFFF
+            return 0;
+        }
+        return 4;
+    }
+    return 0;
+}
+
+// Сколько байт ASCII в начале текста (с шагом в блок, остаток - скалярно)
+std::size_t ascii_prefix(const unsigned char* p, std::size_t size) {
+    std::size_t i = 0;
+#if defined(CHARSET_SSSE3) || defined(CHARSET_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i const block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(block) != 0) {
+            break;
+        }
+    }
+#endif
+    while (i < size && p[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+#if !defined(CHARSET_SSSE3)
+
+bool validate_scalar(const unsigned char* p, std::size_t size) {
+    std::size_t i = 0;
+    while (i < size) {
+        i += ascii_prefix(p + i, size - i);
+        if (i == size) {
+            break;
+        }
+        std::size_t const length = utf8_sequence(p + i, size - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+#endif
+
+#if defined(CHARSET_SSSE3)
+
+// Проверка по таблицам (Keiser, Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte"): класс ошибки определяется старшим и младшим полубайтом
+// предыдущего байта и старшим полубайтом текущего, три pshufb на 16 байт
+constexpr std::uint8_t kTooShort = 1 << 0;     // Ведущий байт без продолжения
+constexpr std::uint8_t kTooLong = 1 << 1;      // Продолжение после ASCII
+constexpr std::uint8_t kOverlong3 = 1 << 2;
+constexpr std::uint8_t kTooLarge = 1 << 3;
+constexpr std::uint8_t kSurrogate = 1 << 4;
+constexpr std::uint8_t kOverlong2 = 1 << 5;
+constexpr std::uint8_t kTooLarge1000 = 1 << 6;
+constexpr std::uint8_t kOverlong4 = 1 << 6;
+constexpr std::uint8_t kTwoConts = 1 << 7;     // Два продолжения подряд
+constexpr std::uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+__m128i table16(const std::uint8_t (&t)[16]) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(t));
+}
+
+bool validate_ssse3(const unsigned char* data, std::size_t size) {
+    static constexpr std::uint8_t byte_1_high[16] = {
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+    };
+    static constexpr std::uint8_t byte_1_low[16] = {
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+    };
+    static constexpr std::uint8_t byte_2_high[16] = {
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+    };
+    // Последовательность, начатая в последних байтах блока, должна продолжиться в следующем
+    static constexpr std::uint8_t incomplete_max[16] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+    };
+
+    __m128i const t1 = table16(byte_1_high);
+    __m128i const t2 = table16(byte_1_low);
+    __m128i const t3 = table16(byte_2_high);
+    __m128i const max_value = table16(incomplete_max);
+    __m128i const low_nibble = _mm_set1_epi8(0x0F);
+
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+
+    auto check = [&](__m128i input) {
+        if (_mm_movemask_epi8(input) == 0) {
+            // Блок ASCII: ошибка, только если предыдущий оборвался посреди символа
+            error = _mm_or_si128(error, prev_incomplete);
+        }
+        else {
+            __m128i const prev1 = _mm_alignr_epi8(input, prev_input, 15);
+            __m128i const special = _mm_and_si128(
+                _mm_and_si128(
+                    _mm_shuffle_epi8(t1, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble)),
+                    _mm_shuffle_epi8(t2, _mm_and_si128(prev1, low_nibble))),
+                _mm_shuffle_epi8(t3, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble)));
+
+            // Третий и четвертый байты трех- и четырехбайтовых последовательностей
+            __m128i const prev2 = _mm_alignr_epi8(input, prev_input, 14);
+            __m128i const prev3 = _mm_alignr_epi8(input, prev_input, 13);
+            __m128i const third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+            __m128i const fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+            __m128i const must_be_continuation = _mm_and_si128(_mm_or_si128(third, fourth),
+                _mm_set1_epi8(static_cast<char>(0x80)));
+
+            error = _mm_or_si128(error, _mm_xor_si128(must_be_continuation, special));
+            prev_incomplete = _mm_subs_epu8(input, max_value);
+        }
+        prev_input = input;
+    };
+
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    if (i < size) {
+        // Хвост дополняется нулями: оборванная последовательность даст ошибку kTooShort
+        alignas(16) unsigned char tail[16] = {};
+        std::memcpy(tail, data + i, size - i);
+        check(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#endif
+
+// Копирует корректные последовательности, некорректные байты заменяет на U+FFFD
+void repair_utf8(std::string_view input, std::string& out) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input.data());
+    std::size_t const size = input.size();
+    out.clear();
+    out.reserve(size + size / 8);
+    std::size_t i = 0;
+    while (i < size) {
+        std::size_t const ascii = ascii_prefix(p + i, size - i);
+        out.append(input.data() + i, ascii);
+        i += ascii;
+        if (i == size) {
+            break;
+        }
+        std::size_t const length = utf8_sequence(p + i, size - i);
+        if (length == 0) {
+            out.append(kReplacement);
+            ++i;
+        }
+        else {
+            out.append(input.data() + i, length);
+            i += length;
+        }
+    }
+}
+
+} // namespace
+
+const char* charset_name(Charset charset) {
+    switch (charset) {
+    case Charset::Utf8:
+        return "utf-8";
+    case Charset::Windows1251:
+        return "windows-1251";
+    case Charset::Koi8R:
+        return "koi8-r";
+    case Charset::Windows1252:
+        return "windows-1252";
+    default:
+        return "unknown";
+    }
+}
+
+Charset charset_from_label(std::string_view label) {
+    std::size_t const first = label.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return Charset::Unknown;
+    }
+    label = label.substr(first, label.find_last_not_of(" \t") - first + 1);
+    if (label.size() > 32) {
+        return Charset::Unknown;
+    }
+    std::string name(label);
+    std::transform(name.begin(), name.end(), name.begin(), to_lower_ascii);
+
+    if (name == "utf-8" || name == "utf8" || name == "unicode-1-1-utf-8") {
+        return Charset::Utf8;
+    }
+    if (name == "windows-1251" || name == "cp1251" || name == "x-cp1251") {
+        return Charset::Windows1251;
+    }
+    if (name == "koi8-r" || name == "koi8_r" || name == "koi8" || name == "koi" || name == "cskoi8r") {
+        return Charset::Koi8R;
+    }
+    if (name == "windows-1252" || name == "cp1252" || name == "x-cp1252" || name == "iso-8859-1" ||
+        name == "iso8859-1" || name == "iso_8859-1" || name == "latin1" || name == "l1" ||
+        name == "us-ascii" || name == "ascii") {
+        return Charset::Windows1252;
+    }
+    return Charset::Unknown;
+}
+
+Charset charset_from_content_type(std::string_view content_type) {
+    std::size_t pos = content_type.find(';');
+    while (pos != std::string_view::npos) {
+        std::size_t const start = content_type.find_first_not_of(" \t", pos + 1);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        if (content_type.size() - start >= 7) {
+            std::string name(content_type.substr(start, 7));
+            std::transform(name.begin(), name.end(), name.begin(), to_lower_ascii);
+            if (name == "charset") {
+                return charset_from_label(charset_value(content_type, start + 7));
+            }
+        }
+        pos = content_type.find(';', start);
+    }
+    return Charset::Unknown;
+}
+
+Charset sniff_meta_charset(std::string_view html) {
+    std::string head(html.substr(0, kMetaPrescanBytes));
+    std::transform(head.begin(), head.end(), head.begin(), to_lower_ascii);
+    std::string_view const text = head;
+
+    // И <meta charset=...>, и content="text/html; charset=..." сводятся к поиску
+    // "charset=" внутри тега <meta>
+    for (std::size_t meta = text.find("<meta"); meta != std::string_view::npos; meta = text.find("<meta", meta + 5)) {
+        std::size_t const end = text.find('>', meta);
+        std::string_view const tag = text.substr(meta, end == std::string_view::npos ? std::string_view::npos : end - meta);
+        for (std::size_t pos = tag.find("charset"); pos != std::string_view::npos; pos = tag.find("charset", pos + 7)) {
+            Charset const charset = charset_from_label(charset_value(tag, pos + 7));
+            if (charset != Charset::Unknown) {
+                return charset;
+            }
+        }
+    }
+    return Charset::Unknown;
+}
+
+bool is_valid_utf8(std::string_view text) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+#if defined(CHARSET_SSSE3)
+    return validate_ssse3(data, text.size());
+#else
+    return validate_scalar(data, text.size());
+#endif
+}
+
+std::string_view decode_html(std::string_view html, std::string_view content_type, Charset fallback,
+    std::string& out, Charset& detected) {
+    // BOM важнее любых объявлений
+    Charset charset = Charset::Unknown;
+    if (html.starts_with("\xEF\xBB\xBF")) {
+        html.remove_prefix(3);
+        charset = Charset::Utf8;
+    }
+    else {
+        charset = charset_from_content_type(content_type);
+        if (charset == Charset::Unknown) {
+            charset = sniff_meta_charset(html);
+        }
+    }
+
+    if (charset == Charset::Unknown || charset == Charset::Utf8) {
+        if (is_valid_utf8(html)) {
+            detected = Charset::Utf8;
+            return html;
+        }
+        if (charset == Charset::Unknown) {
+            charset = fallback == Charset::Unknown ? Charset::Utf8 : fallback;
+        }
+    }
+
+    detected = charset;
+    if (charset == Charset::Utf8) {
+        repair_utf8(html, out);
+    }
+    else {
+        transcode(html, transcode_table(charset), out);
+    }
+    return out;
+}
@@ -0,0 +1,41 @@
+#ifndef CHARSET_H
+#define CHARSET_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Кодировки, которые приводятся к UTF-8 перед разбором страницы
+enum class Charset {
+    Unknown,
+    Utf8,
+    Windows1251,
+    Koi8R,
+    Windows1252, // Также iso-8859-1 и us-ascii: браузеры читают их как windows-1252
+};
+
+constexpr std::size_t kCharsetCount = 5;
+
+// Имя кодировки для статистики и Charset::Unknown для неизвестной метки
+const char* charset_name(Charset charset);
+Charset charset_from_label(std::string_view label);
+
+// Кодировка из параметра charset заголовка Content-Type
+Charset charset_from_content_type(std::string_view content_type);
+
+// <meta charset> или <meta http-equiv="Content-Type"> в первых 1024 байтах страницы
+Charset sniff_meta_charset(std::string_view html);
+
+// Проверка UTF-8 (включая overlong, суррогаты и обрыв последовательности в конце).
+// С SSSE3/AVX2 проверяется по 16 байт за шаг таблицами переходов, иначе ASCII
+// пропускается блоками SSE2, а остальное проверяется скалярно.
+bool is_valid_utf8(std::string_view text);
+
+// Приводит страницу к UTF-8. Кодировка берется из BOM, Content-Type или <meta>;
+// если она не указана, корректный UTF-8 остается UTF-8, остальное читается как fallback.
+// Если страница уже в корректном UTF-8, возвращается сама html без копирования,
+// иначе перекодированный текст в out. Некорректные байты заменяются на U+FFFD.
+std::string_view decode_html(std::string_view html, std::string_view content_type, Charset fallback,
+    std::string& out, Charset& detected);
+
+#endif // CHARSET_H
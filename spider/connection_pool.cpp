@@ -0,0 +1,150 @@
+#include "connection_pool.h"
+#include <algorithm>
+#include <openssl/ssl.h>
+
+namespace {
+
+// TLS-сессии давно не встречавшихся хостов вытесняются сверх этого числа
+constexpr std::size_t kMaxSessions = 4096;
+
+} // namespace
+
+ConnectionPool::ConnectionPool(const Config& config)
+    : max_idle_per_host_(config.max_idle_connections_per_host),
+    max_idle_(static_cast<std::size_t>(std::max(0, config.max_idle_connections))),
+    keep_alive_(config.keep_alive_seconds) {
+}
+
+ConnectionPool::~ConnectionPool() {
+    for (auto& [key, session] : session_lru_) {
+        SSL_SESSION_free(session);
+    }
+}
+
+std::unique_ptr<PooledConnection> ConnectionPool::acquire(const std::string& key) {
+    auto const now = std::chrono::steady_clock::now();
+    std::unique_ptr<PooledConnection> conn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire_locked(now);
+        // Самое свежее соединение хоста - в конце его очереди
+        auto it = idle_.find(key);
+        if (it != idle_.end()) {
+            auto const pos = it->second.back();
+            it->second.pop_back();
+            if (it->second.empty()) {
+                idle_.erase(it);
+            }
+            conn = std::move(*pos);
+            lru_.erase(pos);
+        }
+    }
+
+    if (conn) {
+        hits_++;
+    }
+    else {
+        misses_++;
+    }
+    return conn;
+}
+
+void ConnectionPool::release(std::unique_ptr<PooledConnection> conn) {
+    if (max_idle_per_host_ == 0 || max_idle_ == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const now = std::chrono::steady_clock::now();
+    conn->idle_since = now;
+    expire_locked(now);
+
+    auto& conns = idle_[conn->key];
+    if (conns.size() >= max_idle_per_host_) {
+        lru_.erase(conns.front());
+        conns.pop_front();
+        evicted_++;
+    }
+    conns.push_back(lru_.insert(lru_.end(), std::move(conn)));
+    while (lru_.size() > max_idle_) {
+        erase_oldest_locked();
+        evicted_++;
+    }
+}
+
+// Самое старое соединение в lru_ - первое и в очереди своего хоста
+void ConnectionPool::erase_oldest_locked() {
+    auto const oldest = lru_.begin();
+    auto it = idle_.find((*oldest)->key);
+    it->second.pop_front();
+    if (it->second.empty()) {
+        idle_.erase(it);
+    }
+    lru_.erase(oldest);
+}
+
+void ConnectionPool::expire_locked(std::chrono::steady_clock::time_point now) {
+    while (!lru_.empty() && now - lru_.front()->idle_since > keep_alive_) {
+        erase_oldest_locked();
+        stale_++;
+    }
+}
+
+void ConnectionPool::apply_session(const std::string& key, SSL* ssl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        session_lru_.splice(session_lru_.begin(), session_lru_, it->second);
+        SSL_set_session(ssl, it->second->second);
+    }
+}
+
+void ConnectionPool::store_session(const std::string& key, SSL* ssl) {
+    SSL_SESSION* session = SSL_get1_session(ssl);
+    if (!session) {
+        return;
+    }
+    if (!SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        SSL_SESSION_free(it->second->second);
+        it->second->second = session;
+        session_lru_.splice(session_lru_.begin(), session_lru_, it->second);
+        return;
+    }
+    session_lru_.emplace_front(key, session);
+    sessions_.emplace(key, session_lru_.begin());
+    if (session_lru_.size() > kMaxSessions) {
+        auto& [oldest_key, oldest] = session_lru_.back();
+        SSL_SESSION_free(oldest);
+        sessions_.erase(oldest_key);
+        session_lru_.pop_back();
+    }
+}
+
+void ConnectionPool::record_handshake(SSL* ssl) {
+    tls_handshakes_++;
+    if (SSL_session_reused(ssl)) {
+        tls_resumed_++;
+    }
+}
+
+void ConnectionPool::record_stale() {
+    stale_++;
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.stale = stale_;
+    s.evicted = evicted_;
+    s.tls_handshakes = tls_handshakes_;
+    s.tls_resumed = tls_resumed_;
+    return s;
+}
@@ -0,0 +1,92 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+#include "../config/config.h"
+
+// Постоянное (keep-alive) соединение с хостом: TCP либо TLS поверх TCP
+struct PooledConnection {
+    std::string key; // scheme://host:port
+    std::unique_ptr<boost::beast::tcp_stream> plain;
+    std::unique_ptr<boost::beast::ssl_stream<boost::beast::tcp_stream>> secure;
+    boost::beast::flat_buffer buffer; // Непрочитанные данные между ответами
+    std::chrono::steady_clock::time_point idle_since;
+
+    boost::beast::tcp_stream& lowest_layer() {
+        return secure ? boost::beast::get_lowest_layer(*secure) : *plain;
+    }
+};
+
+// Пул простаивающих соединений по хостам и кэш TLS-сессий для их возобновления.
+// Простаивающие соединения всех хостов стоят в одной очереди по времени
+// возврата: при каждом release закрываются просроченные и самые старые сверх
+// общего лимита, так что число открытых сокетов не растет с числом хостов.
+class ConnectionPool {
+public:
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t stale = 0;
+        std::size_t evicted = 0; // Закрыты сверх лимитов на хост и на все хосты
+        std::size_t tls_handshakes = 0;
+        std::size_t tls_resumed = 0;
+    };
+
+    explicit ConnectionPool(const Config& config);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Возвращает простаивающее соединение к хосту или nullptr
+    std::unique_ptr<PooledConnection> acquire(const std::string& key);
+    void release(std::unique_ptr<PooledConnection> conn);
+
+    // TLS-сессии: подставляются перед рукопожатием и сохраняются после ответа
+    void apply_session(const std::string& key, SSL* ssl);
+    void store_session(const std::string& key, SSL* ssl);
+    void record_handshake(SSL* ssl);
+    void record_stale();
+
+    Stats stats() const;
+
+private:
+    using IdleList = std::list<std::unique_ptr<PooledConnection>>;
+
+    void erase_oldest_locked();
+    void expire_locked(std::chrono::steady_clock::time_point now);
+
+    std::size_t max_idle_per_host_;
+    std::size_t max_idle_;
+    std::chrono::seconds keep_alive_;
+
+    std::mutex mutex_;
+    IdleList lru_; // Все простаивающие соединения, старые в начале
+    // Соединения хоста в lru_, в том же порядке; пустые очереди удаляются
+    std::unordered_map<std::string, std::deque<IdleList::iterator>> idle_;
+
+    // TLS-сессии с вытеснением давно не использованных
+    using SessionList = std::list<std::pair<std::string, SSL_SESSION*>>;
+    SessionList session_lru_; // Недавно использованные в начале
+    std::unordered_map<std::string, SessionList::iterator> sessions_;
+
+    std::atomic<std::size_t> hits_{ 0 };
+    std::atomic<std::size_t> misses_{ 0 };
+    std::atomic<std::size_t> stale_{ 0 };
+    std::atomic<std::size_t> evicted_{ 0 };
+    std::atomic<std::size_t> tls_handshakes_{ 0 };
+    std::atomic<std::size_t> tls_resumed_{ 0 };
+};
+
+#endif // CONNECTION_POOL_H
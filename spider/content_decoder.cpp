@@ -0,0 +1,217 @@
+#include "content_decoder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace {
+
+// Шаг, на который растет выходная строка при распаковке
+constexpr std::size_t kOutputStep = 32 * 1024;
+
+std::string lower_trimmed(std::string_view value) {
+    std::size_t const first = value.find_first_not_of(" \t");
+    std::size_t const last = value.find_last_not_of(" \t");
+    std::string result;
+    if (first == std::string_view::npos) {
+        return result;
+    }
+    for (char c : value.substr(first, last - first + 1)) {
+        result += static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    }
+    return result;
+}
+
+} // namespace
+
+struct ContentDecoder::State {
+    z_stream zlib{};
+    bool zlib_ready = false;
+    bool received = false; // Был хотя бы один непустой кусок
+    bool finished = false;
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+    BrotliDecoderState* brotli = nullptr;
+#endif
+
+    void release() {
+        if (zlib_ready) {
+            inflateEnd(&zlib);
+            zlib_ready = false;
+        }
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+        if (brotli) {
+            BrotliDecoderDestroyInstance(brotli);
+            brotli = nullptr;
+        }
+#endif
+        received = false;
+        finished = false;
+    }
+
+    ~State() { release(); }
+};
+
+ContentDecoder::ContentDecoder() : state_(std::make_unique<State>()) {
+}
+
+ContentDecoder::~ContentDecoder() = default;
+
+const char* ContentDecoder::accept_encoding() {
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+    return "gzip, deflate, br";
+#else
+    return "gzip, deflate";
+#endif
+}
+
+bool ContentDecoder::reset(std::string_view encoding, std::size_t max_output) {
+    state_->release();
+    max_output_ = max_output;
+
+    std::string const name = lower_trimmed(encoding);
+    if (name.empty() || name == "identity") {
+        encoding_ = Encoding::Identity;
+    }
+    else if (name == "gzip" || name == "x-gzip") {
+        encoding_ = Encoding::Gzip;
+    }
+    else if (name == "deflate") {
+        encoding_ = Encoding::Deflate;
+    }
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+    else if (name == "br") {
+        encoding_ = Encoding::Brotli;
+        state_->brotli = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!state_->brotli) {
+            throw std::bad_alloc();
+        }
+    }
+#endif
+    else {
+        return false;
+    }
+    return true;
+}
+
+void ContentDecoder::check_limit(const std::string& out) const {
+    if (out.size() > max_output_) {
+        throw std::length_error("Response body exceeds " + std::to_string(max_output_) + " bytes");
+    }
+}
+
+void ContentDecoder::write(const char* data, std::size_t size, std::string& out) {
+    if (size == 0) {
+        return;
+    }
+    state_->received = true;
+    switch (encoding_) {
+    case Encoding::Identity:
+        if (out.size() + size > max_output_) {
+            throw std::length_error("Response body exceeds " + std::to_string(max_output_) + " bytes");
+        }
+        out.append(data, size);
+        break;
+    case Encoding::Gzip:
+    case Encoding::Deflate:
+        write_zlib(data, size, out);
+        break;
+    case Encoding::Brotli:
+        write_brotli(data, size, out);
+        break;
+    }
+}
+
+// Пустое тело не считается обрывом: его отдают, например, ответы без содержимого
+void ContentDecoder::finish() const {
+    if (encoding_ != Encoding::Identity && state_->received && !state_->finished) {
+        throw std::runtime_error("Truncated compressed body");
+    }
+}
+
+void ContentDecoder::write_zlib(const char* data, std::size_t size, std::string& out) {
+    State& state = *state_;
+    if (state.finished) {
+        return; // Данные после конца потока игнорируются
+    }
+    if (!state.zlib_ready) {
+        // gzip и zlib различаются автоматически (+32). "deflate" некоторые
+        // серверы отдают без заголовка zlib: такой поток распаковывается как сырой.
+        int window_bits = 15 + 32;
+        if (encoding_ == Encoding::Deflate && size >= 2) {
+            unsigned const cmf = static_cast<unsigned char>(data[0]);
+            unsigned const flg = static_cast<unsigned char>(data[1]);
+            if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0) {
+                window_bits = -15;
+            }
+        }
+        if (inflateInit2(&state.zlib, window_bits) != Z_OK) {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+        state.zlib_ready = true;
+    }
+
+    z_stream& zs = state.zlib;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+    do {
+        std::size_t const used = out.size();
+        std::size_t const room = std::min(std::max(kOutputStep, size * 4), max_output_ - std::min(used, max_output_) + 1);
+        out.resize(used + room);
+        zs.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+        zs.avail_out = static_cast<uInt>(room);
+
+        int const ret = inflate(&zs, Z_NO_FLUSH);
+        out.resize(used + room - zs.avail_out);
+        if (ret == Z_STREAM_END) {
+            state.finished = true;
+            break;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("Corrupt compressed body: ") + (zs.msg ? zs.msg : "inflate error"));
+        }
+        check_limit(out);
+    } while (zs.avail_in > 0 || zs.avail_out == 0);
+    check_limit(out);
+}
+
+void ContentDecoder::write_brotli(const char* data, std::size_t size, std::string& out) {
+#ifdef SEARCH_ENGINE_WITH_BROTLI
+    State& state = *state_;
+    if (state.finished) {
+        return;
+    }
+    std::size_t available_in = size;
+    const std::uint8_t* next_in = reinterpret_cast<const std::uint8_t*>(data);
+    while (true) {
+        std::size_t const used = out.size();
+        std::size_t const room = std::min(std::max(kOutputStep, size * 4), max_output_ - std::min(used, max_output_) + 1);
+        out.resize(used + room);
+        std::size_t available_out = room;
+        std::uint8_t* next_out = reinterpret_cast<std::uint8_t*>(out.data() + used);
+
+        BrotliDecoderResult const result = BrotliDecoderDecompressStream(state.brotli,
+            &available_in, &next_in, &available_out, &next_out, nullptr);
+        out.resize(used + room - available_out);
+        check_limit(out);
+
+        if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+            state.finished = true;
+            return;
+        }
+        if (result == BROTLI_DECODER_RESULT_ERROR) {
+            throw std::runtime_error(std::string("Corrupt brotli body: ") +
+                BrotliDecoderErrorString(BrotliDecoderGetErrorCode(state.brotli)));
+        }
+        if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+            return;
+        }
+    }
+#else
+    (void)data;
+    (void)size;
+    (void)out;
+    throw std::runtime_error("Built without brotli support");
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef CONTENT_DECODER_H
+#define CONTENT_DECODER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Потоковая распаковка тела ответа по Content-Encoding (gzip, deflate и,
+// если собрано с brotli, br). Куски тела дописываются прямо в итоговую
+// строку; размер распакованных данных ограничен, чтобы не пропустить
+// "zip-бомбу".
+class ContentDecoder {
+public:
+    ContentDecoder();
+    ~ContentDecoder();
+
+    ContentDecoder(const ContentDecoder&) = delete;
+    ContentDecoder& operator=(const ContentDecoder&) = delete;
+
+    // Значение заголовка Accept-Encoding для поддерживаемых кодировок
+    static const char* accept_encoding();
+
+    // Готовит декодер к новому телу; false, если кодировка не поддерживается
+    bool reset(std::string_view encoding, std::size_t max_output);
+
+    // Распаковывает очередной кусок в out. При превышении лимита бросает std::length_error,
+    // при поврежденных данных - std::runtime_error.
+    void write(const char* data, std::size_t size, std::string& out);
+
+    // Вызывается после последнего куска: бросает std::runtime_error, если сжатый
+    // поток оборвался до своего конца (тело обрезано сервером или прокси)
+    void finish() const;
+
+private:
+    struct State;
+
+    void write_zlib(const char* data, std::size_t size, std::string& out);
+    void write_brotli(const char* data, std::size_t size, std::string& out);
+    void check_limit(const std::string& out) const;
+
+    enum class Encoding { Identity, Gzip, Deflate, Brotli };
+
+    Encoding encoding_ = Encoding::Identity;
+    std::size_t max_output_ = 0;
+    std::unique_ptr<State> state_;
+};
+
+#endif // CONTENT_DECODER_H
@@ -0,0 +1,147 @@
+#include "dns_cache.h"
+#include <algorithm>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+DnsCache::DnsCache(const Config& config)
+    : ttl_(config.dns_cache_ttl_seconds),
+    negative_ttl_(std::min(config.dns_cache_ttl_seconds, 30)),
+    timeout_(config.request_timeout_seconds) {
+}
+
+net::awaitable<DnsCache::Results> DnsCache::resolve(const std::string& host, const std::string& service) {
+    std::string const key = host + ":" + service;
+    auto const now = std::chrono::steady_clock::now();
+
+    std::shared_ptr<Entry> entry;
+    bool owner = false;
+    bool ready = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() >= sweep_at_) {
+            sweep_locked(now);
+        }
+        auto& slot = entries_[key];
+        if (!slot || (slot->ready && now >= slot->expires)) {
+            slot = std::make_shared<Entry>();
+            owner = true;
+        }
+        entry = slot;
+        ready = entry->ready;
+    }
+
+    if (owner) {
+        misses_++;
+        boost::system::error_code ec;
+        Results results = co_await resolve_with_timeout(host, service, ec);
+        if (ec) {
+            failures_++;
+        }
+
+        std::vector<std::function<void()>> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entry->results = std::move(results);
+            entry->error = ec;
+            entry->expires = std::chrono::steady_clock::now() + (ec ? negative_ttl_ : ttl_);
+            entry->ready = true;
+            waiters.swap(entry->waiters);
+        }
+        for (auto& resume : waiters) {
+            resume();
+        }
+    }
+    else if (ready) {
+        hits_++;
+    }
+    else {
+        // Имя уже разрешается другой корутиной: дожидаемся ее результата
+        coalesced_++;
+        co_await wait_for(entry);
+    }
+
+    // После ready запись больше не меняется
+    if (entry->error) {
+        throw boost::system::system_error{ entry->error };
+    }
+    co_return entry->results;
+}
+
+// Таймер отменяет разрешение имени. Обработчик таймера может выполниться и
+// после возврата из корутины, поэтому resolver принадлежит ему совместно.
+net::awaitable<DnsCache::Results> DnsCache::resolve_with_timeout(const std::string& host, const std::string& service,
+    boost::system::error_code& ec) {
+    auto const executor = co_await net::this_coro::executor;
+    auto resolver = std::make_shared<tcp::resolver>(executor);
+    auto expired = std::make_shared<bool>(false);
+    net::steady_timer timer(executor);
+    timer.expires_after(timeout_);
+    timer.async_wait([resolver, expired](const boost::system::error_code& error) {
+        if (!error) {
+            *expired = true;
+            resolver->cancel();
+        }
+        });
+
+    Results results = co_await resolver->async_resolve(host, service, net::redirect_error(net::use_awaitable, ec));
+    timer.cancel();
+    if (*expired && ec == net::error::operation_aborted) {
+        timeouts_++;
+        ec = net::error::timed_out;
+    }
+    co_return results;
+}
+
+// Записи, которые еще разрешаются, остаются: их ждут другие корутины
+void DnsCache::sweep_locked(std::chrono::steady_clock::time_point now) {
+    std::size_t const before = entries_.size();
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second->ready && now >= it->second->expires) {
+            it = entries_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    evicted_ += before - entries_.size();
+    sweep_at_ = std::max(kMinSweep, entries_.size() * 2);
+}
+
+net::awaitable<void> DnsCache::wait_for(std::shared_ptr<Entry> entry) {
+    co_await net::async_initiate<const net::use_awaitable_t<>&, void()>(
+        [this, entry](auto handler) {
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            std::function<void()> resume = [shared]() {
+                auto executor = net::get_associated_executor(*shared);
+                net::post(executor, [shared]() { (*shared)(); });
+            };
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!entry->ready) {
+                entry->waiters.push_back(std::move(resume));
+                return;
+            }
+            lock.unlock();
+            resume();
+        },
+        net::use_awaitable);
+}
+
+DnsCache::Stats DnsCache::stats() const {
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.coalesced = coalesced_;
+    s.failures = failures_;
+    s.timeouts = timeouts_;
+    s.evicted = evicted_;
+    return s;
+}
@@ -0,0 +1,73 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include "../config/config.h"
+
+// Общий для всех загрузчиков кэш DNS с ограниченным временем жизни записей.
+// Одновременные запросы одного хоста объединяются в одно разрешение имени,
+// которое ограничено тем же таймаутом, что и запрос. Истекшие записи
+// вычищаются, когда кэш вырастает вдвое с прошлой чистки: в нем остаются
+// только хосты, разрешенные за последние dns_cache_ttl_seconds.
+class DnsCache {
+public:
+    using Results = boost::asio::ip::tcp::resolver::results_type;
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t coalesced = 0;
+        std::size_t failures = 0;
+        std::size_t timeouts = 0;
+        std::size_t evicted = 0;
+    };
+
+    explicit DnsCache(const Config& config);
+
+    boost::asio::awaitable<Results> resolve(const std::string& host, const std::string& service);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        bool ready = false;
+        Results results;
+        boost::system::error_code error;
+        std::chrono::steady_clock::time_point expires;
+        std::vector<std::function<void()>> waiters; // Ждущие завершения разрешения
+    };
+
+    static constexpr std::size_t kMinSweep = 1024;
+
+    boost::asio::awaitable<void> wait_for(std::shared_ptr<Entry> entry);
+    boost::asio::awaitable<Results> resolve_with_timeout(const std::string& host, const std::string& service,
+        boost::system::error_code& ec);
+    void sweep_locked(std::chrono::steady_clock::time_point now);
+
+    std::chrono::seconds ttl_;
+    std::chrono::seconds negative_ttl_;
+    std::chrono::seconds timeout_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+    std::size_t sweep_at_ = kMinSweep; // Размер, при котором вычищаются истекшие записи
+
+    std::atomic<std::size_t> hits_{ 0 };
+    std::atomic<std::size_t> misses_{ 0 };
+    std::atomic<std::size_t> coalesced_{ 0 };
+    std::atomic<std::size_t> failures_{ 0 };
+    std::atomic<std::size_t> timeouts_{ 0 };
+    std::atomic<std::size_t> evicted_{ 0 };
+};
+
+#endif // DNS_CACHE_H
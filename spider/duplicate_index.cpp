@@ -0,0 +1,89 @@
+#include "duplicate_index.h"
+#include <algorithm>
+#include <bit>
+#include "hash.h"
+
+std::uint64_t simhash(const TermTable& terms) {
+    int weights[64] = {};
+    terms.for_each([&](std::string_view term, int count) {
+        std::uint64_t const h = hash64(term);
+        for (int bit = 0; bit < 64; ++bit) {
+            weights[bit] += (h >> bit) & 1 ? count : -count;
+        }
+    });
+
+    std::uint64_t result = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[bit] > 0) {
+            result |= std::uint64_t(1) << bit;
+        }
+    }
+    return result;
+}
+
+DuplicateIndex::DuplicateIndex(const Config& config)
+    : max_distance_(std::min(config.near_duplicate_distance, 15)),
+    bands_(std::max(max_distance_, 0) + 1),
+    band_bits_(64 / bands_),
+    band_tables_(bands_) {
+}
+
+// Значение полосы band; последняя полоса забирает оставшиеся биты
+std::uint64_t DuplicateIndex::band_key(std::uint64_t hash, int band) const {
+    int const shift = band * band_bits_;
+    int const width = band == bands_ - 1 ? 64 - shift : band_bits_;
+    std::uint64_t const mask = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+    return (hash >> shift) & mask;
+}
+
+std::optional<std::string> DuplicateIndex::check(const std::string& url, std::uint64_t exact_hash,
+    std::uint64_t hash, std::size_t term_count) {
+    if (!enabled()) {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto exact = exact_.find(exact_hash);
+    if (exact != exact_.end()) {
+        exact_hits_++;
+        return urls_[exact->second];
+    }
+
+    bool const use_simhash = term_count >= kMinTermsForSimhash;
+    if (use_simhash) {
+        for (int band = 0; band < bands_; ++band) {
+            auto it = band_tables_[band].find(band_key(hash, band));
+            if (it == band_tables_[band].end()) {
+                continue;
+            }
+            for (std::uint32_t id : it->second) {
+                if (std::popcount(simhashes_[id] ^ hash) <= max_distance_) {
+                    near_hits_++;
+                    return urls_[id];
+                }
+            }
+        }
+    }
+
+    std::uint32_t const id = static_cast<std::uint32_t>(urls_.size());
+    urls_.push_back(url);
+    simhashes_.push_back(hash);
+    exact_.emplace(exact_hash, id);
+    if (use_simhash) {
+        for (int band = 0; band < bands_; ++band) {
+            band_tables_[band][band_key(hash, band)].push_back(id);
+        }
+    }
+    return std::nullopt;
+}
+
+DuplicateIndex::Stats DuplicateIndex::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.documents = urls_.size();
+    }
+    stats.exact = exact_hits_;
+    stats.near = near_hits_;
+    return stats;
+}
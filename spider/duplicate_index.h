@@ -0,0 +1,61 @@
+#ifndef DUPLICATE_INDEX_H
+#define DUPLICATE_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../config/config.h"
+#include "tokenizer.h"
+
+// 64-битный SimHash по частотам слов: у похожих страниц отличается мало битов
+std::uint64_t simhash(const TermTable& terms);
+
+// Индекс отпечатков уже проиндексированных страниц. Точные копии ищутся
+// по хэшу текста, почти копии - по SimHash с расстоянием Хэмминга не больше
+// max_distance. SimHash делится на max_distance + 1 полос: по принципу
+// Дирихле у близких отпечатков хотя бы одна полоса совпадает целиком.
+class DuplicateIndex {
+public:
+    struct Stats {
+        std::size_t documents = 0;
+        std::size_t exact = 0;
+        std::size_t near = 0;
+    };
+
+    explicit DuplicateIndex(const Config& config);
+
+    // Если страница дублирует уже известную, возвращает URL оригинала;
+    // иначе запоминает ее отпечатки и возвращает nullopt
+    std::optional<std::string> check(const std::string& url, std::uint64_t exact_hash,
+        std::uint64_t hash, std::size_t term_count);
+
+    bool enabled() const { return max_distance_ >= 0; }
+    Stats stats() const;
+
+private:
+    // Короткие страницы дают неустойчивый SimHash, для них ищутся только точные копии
+    static constexpr std::size_t kMinTermsForSimhash = 32;
+
+    std::uint64_t band_key(std::uint64_t hash, int band) const;
+
+    int max_distance_;
+    int bands_;
+    int band_bits_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint64_t, std::uint32_t> exact_;              // хэш текста -> документ
+    std::vector<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>> band_tables_;
+    std::vector<std::uint64_t> simhashes_;
+    std::vector<std::string> urls_;
+
+    std::atomic<std::size_t> exact_hits_{ 0 };
+    std::atomic<std::size_t> near_hits_{ 0 };
+};
+
+#endif // DUPLICATE_INDEX_H
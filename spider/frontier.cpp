@@ -0,0 +1,286 @@
+#include "frontier.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include "frontier_store.h"
+#include "url.h"
+#include "visited_set.h"
+
+namespace {
+
+// Накладные расходы на задачу в разделе сверх байтов URL
+constexpr std::size_t kTaskOverhead = 64;
+
+std::string host_of(const std::string& url) {
+    UrlParts parts;
+    if (!parse_url(url, parts)) {
+        return {};
+    }
+    std::string host(parts.host);
+    if (!parts.port.empty()) {
+        host += ':';
+        host.append(parts.port);
+    }
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+    return host;
+}
+
+} // namespace
+
+Frontier::Frontier(const Config& config, std::size_t partitions)
+    : politeness_delay_(config.politeness_delay_ms) {
+    partitions = std::max<std::size_t>(partitions, 1);
+    for (std::size_t i = 0; i < partitions; ++i) {
+        partitions_.push_back(std::make_unique<Partition>());
+    }
+    if (!config.frontier_dir.empty()) {
+        store_ = std::make_unique<FrontierStore>(config.frontier_dir);
+        memory_budget_ = std::size_t(std::max(1, config.frontier_memory_megabytes)) * 1024 * 1024;
+    }
+}
+
+Frontier::~Frontier() = default;
+
+std::size_t Frontier::size() const {
+    return size_ + spilled();
+}
+
+std::size_t Frontier::spilled() const {
+    return store_ ? store_->pending() : 0;
+}
+
+void Frontier::reset() {
+    if (store_) {
+        store_->reset();
+    }
+}
+
+bool Frontier::resume(VisitedSet& visited) {
+    if (!store_) {
+        return false;
+    }
+    return store_->resume([&visited](std::uint64_t fp) { visited.insert_fingerprint(fp); });
+}
+
+void Frontier::checkpoint(VisitedSet& visited) {
+    if (!store_) {
+        return;
+    }
+    std::vector<CrawlTask> snapshot;
+    snapshot.reserve(size_);
+    for (auto& partition : partitions_) {
+        std::lock_guard<std::mutex> lock(partition->mutex);
+        for (const auto& [host, queue] : partition->hosts) {
+            for (std::size_t depth = 0; depth < queue.by_depth.size(); ++depth) {
+                for (const std::string& url : queue.by_depth[depth]) {
+                    snapshot.push_back(CrawlTask{ url, static_cast<int>(depth) });
+                }
+            }
+        }
+    }
+    store_->checkpoint(snapshot, visited.take_journal());
+}
+
+// Задача уходит на диск, если разделы заняли весь бюджет памяти
+bool Frontier::spill(CrawlTask& task) {
+    if (!store_ || memory_bytes_ < memory_budget_) {
+        return false;
+    }
+    store_->append(task);
+    return true;
+}
+
+// Когда в памяти осталось меньше половины бюджета, задачи читаются с диска
+// пачкой; подгружает один поток, остальные продолжают работать
+void Frontier::refill() {
+    if (!store_ || store_->pending() == 0 || memory_bytes_ >= memory_budget_ / 2) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(refill_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    std::vector<CrawlTask> tasks;
+    store_->read(memory_budget_ / 4, tasks);
+    push_batch(std::move(tasks), false);
+}
+
+std::size_t Frontier::partition_of(const std::string& host) const {
+    return std::hash<std::string>{}(host) % partitions_.size();
+}
+
+void Frontier::push(CrawlTask task) {
+    if (spill(task)) {
+        return;
+    }
+    std::string host = host_of(task.url);
+    Partition& partition = *partitions_[partition_of(host)];
+    std::lock_guard<std::mutex> lock(partition.mutex);
+    push_locked(partition, std::move(host), std::move(task), Clock::now());
+}
+
+void Frontier::push(std::vector<CrawlTask> tasks) {
+    push_batch(std::move(tasks), true);
+}
+
+void Frontier::push_batch(std::vector<CrawlTask> tasks, bool may_spill) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<std::pair<std::string, CrawlTask>>> groups(partitions_.size());
+    for (auto& task : tasks) {
+        if (may_spill && spill(task)) {
+            continue;
+        }
+        std::string host = host_of(task.url);
+        groups[partition_of(host)].emplace_back(std::move(host), std::move(task));
+    }
+
+    auto const now = Clock::now();
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        if (groups[i].empty()) {
+            continue;
+        }
+        Partition& partition = *partitions_[i];
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        for (auto& [host, task] : groups[i]) {
+            push_locked(partition, std::move(host), std::move(task), now);
+        }
+    }
+}
+
+void Frontier::push_locked(Partition& partition, std::string host, CrawlTask task, Clock::time_point now) {
+    expire_locked(partition, now);
+    HostQueue& queue = partition.hosts[host];
+    auto const depth = static_cast<std::size_t>(std::max(task.depth, 0));
+    if (queue.by_depth.size() <= depth) {
+        queue.by_depth.resize(depth + 1);
+    }
+    memory_bytes_ += task.url.size() + kTaskOverhead;
+    queue.by_depth[depth].push_back(std::move(task.url));
+    queue.size++;
+    partition.size++;
+    size_++;
+
+    if (!queue.scheduled) {
+        schedule_locked(partition, host, queue, now);
+    }
+}
+
+void Frontier::schedule_locked(Partition& partition, const std::string& host, HostQueue& queue, Clock::time_point now) {
+    queue.scheduled = true;
+    if (queue.next_allowed > now) {
+        partition.waiting.emplace(queue.next_allowed, host);
+        return;
+    }
+
+    std::size_t depth = 0;
+    while (queue.by_depth[depth].empty()) {
+        ++depth;
+    }
+    if (partition.ready.size() <= depth) {
+        partition.ready.resize(depth + 1);
+    }
+    partition.ready[depth].push_back(host);
+}
+
+// Хосты, у которых истекла задержка вежливости, становятся готовыми;
+// хосты, так и оставшиеся пустыми, удаляются. Вызывается и из push_locked,
+// чтобы пустые хосты не копились в разделе, из которого ничего не берут.
+void Frontier::expire_locked(Partition& partition, Clock::time_point now) {
+    while (!partition.waiting.empty() && partition.waiting.top().first <= now) {
+        std::string host = partition.waiting.top().second;
+        partition.waiting.pop();
+        auto it = partition.hosts.find(host);
+        if (it == partition.hosts.end()) {
+            continue;
+        }
+        HostQueue& queue = it->second;
+        queue.scheduled = false;
+        if (queue.size == 0) {
+            partition.hosts.erase(it);
+            continue;
+        }
+        schedule_locked(partition, host, queue, now);
+    }
+}
+
+std::optional<CrawlTask> Frontier::pop_locked(Partition& partition, Clock::time_point now) {
+    expire_locked(partition, now);
+
+    for (auto& hosts : partition.ready) {
+        if (hosts.empty()) {
+            continue;
+        }
+
+        std::string host = std::move(hosts.front());
+        hosts.pop_front();
+        HostQueue& queue = partition.hosts[host];
+
+        CrawlTask task;
+        for (std::size_t depth = 0; depth < queue.by_depth.size(); ++depth) {
+            auto& urls = queue.by_depth[depth];
+            if (!urls.empty()) {
+                task.url = std::move(urls.front());
+                task.depth = static_cast<int>(depth);
+                urls.pop_front();
+                break;
+            }
+        }
+        queue.size--;
+        partition.size--;
+        size_--;
+        memory_bytes_ -= task.url.size() + kTaskOverhead;
+
+        queue.next_allowed = now + politeness_delay_;
+        queue.scheduled = false;
+        if (queue.size > 0) {
+            schedule_locked(partition, host, queue, now);
+        }
+        else if (politeness_delay_.count() == 0) {
+            partition.hosts.erase(host);
+        }
+        else {
+            // Пустой хост нужен до конца задержки, чтобы новые URL ее соблюдали;
+            // по ее истечении он удаляется, если URL так и не появились
+            queue.scheduled = true;
+            partition.waiting.emplace(queue.next_allowed, host);
+        }
+        return task;
+    }
+    return std::nullopt;
+}
+
+std::optional<CrawlTask> Frontier::pop(std::size_t worker) {
+    refill();
+    auto const now = Clock::now();
+    std::size_t const home = worker % partitions_.size();
+
+    {
+        Partition& partition = *partitions_[home];
+        if (partition.size > 0) {
+            std::lock_guard<std::mutex> lock(partition.mutex);
+            if (auto task = pop_locked(partition, now)) {
+                return task;
+            }
+        }
+    }
+
+    // Свой раздел пуст: воруем у соседей, не дожидаясь занятых блокировок
+    for (std::size_t i = 1; i < partitions_.size(); ++i) {
+        Partition& partition = *partitions_[(home + i) % partitions_.size()];
+        if (partition.size == 0) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(partition.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            continue;
+        }
+        if (auto task = pop_locked(partition, now)) {
+            steals_++;
+            return task;
+        }
+    }
+    return std::nullopt;
+}
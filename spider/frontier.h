@@ -0,0 +1,97 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../config/config.h"
+
+// Задача обхода: URL и глубина, на которой он найден
+struct CrawlTask {
+    std::string url;
+    int depth = 0;
+};
+
+class FrontierStore;
+class VisitedSet;
+
+// Граница обхода, разбитая на разделы по хостам. Каждый загрузчик берет задачи
+// из своего раздела и ворует из чужих, только когда в своем нет готовых хостов.
+// Внутри раздела хосты выдаются по возрастанию глубины с задержкой вежливости.
+// Если задан spider.frontier_dir, задачи сверх бюджета памяти вытесняются на
+// диск и подгружаются обратно, а состояние сохраняется контрольными точками.
+class Frontier {
+public:
+    Frontier(const Config& config, std::size_t partitions);
+    ~Frontier();
+
+    void push(CrawlTask task);
+    // Пачка ссылок с одной страницы: одна блокировка на затронутый раздел
+    void push(std::vector<CrawlTask> tasks);
+
+    std::optional<CrawlTask> pop(std::size_t worker);
+
+    // Задачи в памяти и на диске
+    std::size_t size() const;
+    std::size_t spilled() const;
+    std::size_t steals() const { return steals_; }
+
+    bool persistent() const { return store_ != nullptr; }
+    // Новый обход: удаляет сохраненное состояние
+    void reset();
+    // Продолжает обход с последней контрольной точки; false, если ее нет
+    bool resume(VisitedSet& visited);
+    // Сохраняет границу и новые отпечатки visited. Вызывается, когда загрузчики
+    // остановлены и все взятые задачи обработаны.
+    void checkpoint(VisitedSet& visited);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct HostQueue {
+        std::vector<std::deque<std::string>> by_depth; // Индекс - глубина
+        std::size_t size = 0;
+        Clock::time_point next_allowed;
+        bool scheduled = false; // Хост находится в ready или waiting
+    };
+
+    struct Partition {
+        std::mutex mutex;
+        std::unordered_map<std::string, HostQueue> hosts;
+        std::vector<std::deque<std::string>> ready; // Готовые хосты по минимальной глубине
+        // Хосты, ожидающие окончания задержки вежливости
+        std::priority_queue<std::pair<Clock::time_point, std::string>,
+            std::vector<std::pair<Clock::time_point, std::string>>,
+            std::greater<>> waiting;
+        std::atomic<std::size_t> size{ 0 };
+    };
+
+    std::size_t partition_of(const std::string& host) const;
+    void push_locked(Partition& partition, std::string host, CrawlTask task, Clock::time_point now);
+    void schedule_locked(Partition& partition, const std::string& host, HostQueue& queue, Clock::time_point now);
+    std::optional<CrawlTask> pop_locked(Partition& partition, Clock::time_point now);
+    void expire_locked(Partition& partition, Clock::time_point now);
+    void push_batch(std::vector<CrawlTask> tasks, bool may_spill);
+    bool spill(CrawlTask& task);
+    void refill();
+
+    std::chrono::milliseconds politeness_delay_;
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::atomic<std::size_t> size_{ 0 };
+    std::atomic<std::size_t> steals_{ 0 };
+
+    std::unique_ptr<FrontierStore> store_;
+    std::size_t memory_budget_ = 0;
+    std::atomic<std::size_t> memory_bytes_{ 0 }; // Оценка памяти под задачи в разделах
+    std::mutex refill_mutex_;
+};
+
+#endif // FRONTIER_H
@@ -0,0 +1,318 @@
+#include "frontier_store.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+namespace ipc = boost::interprocess;
+
+namespace {
+
+// Сегмент закрывается на запись, когда достигает этого размера
+constexpr std::uint64_t kSegmentBytes = 64 * 1024 * 1024;
+
+constexpr const char* kCheckpointFile = "checkpoint";
+constexpr const char* kVisitedFile = "visited.log";
+
+bool parse_segment_id(const fs::path& path, std::uint64_t& id) {
+    std::string const name = path.filename().string();
+    if (name.rfind("segment-", 0) != 0 || path.extension() != ".seg") {
+        return false;
+    }
+    try {
+        id = std::stoull(name.substr(8));
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Сбрасывает данные файла на диск. Без этого после отключения питания
+// манифест мог бы оказаться на диске раньше данных, на которые он ссылается.
+void sync_file(const fs::path& path) {
+#ifdef _WIN32
+    int const fd = _wopen(path.c_str(), _O_RDWR | _O_BINARY);
+    bool const ok = fd >= 0 && _commit(fd) == 0;
+    if (fd >= 0) {
+        _close(fd);
+    }
+#else
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    bool const ok = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+    if (!ok) {
+        throw std::runtime_error("Cannot sync " + path.string());
+    }
+}
+
+// Переименование файла долговечно, только когда записан сам каталог.
+// В Windows каталог так не открыть, и NTFS журналирует переименование сама.
+void sync_directory(const fs::path& path) {
+#ifndef _WIN32
+    sync_file(path);
+#else
+    (void)path;
+#endif
+}
+
+} // namespace
+
+FrontierStore::FrontierStore(fs::path dir) : dir_(std::move(dir)) {
+    fs::create_directories(dir_);
+}
+
+fs::path FrontierStore::segment_path(std::uint64_t id) const {
+    return dir_ / ("segment-" + std::to_string(id) + ".seg");
+}
+
+void FrontierStore::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_writer();
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        std::uint64_t id;
+        auto const name = entry.path().filename().string();
+        if (parse_segment_id(entry.path(), id) || name == kVisitedFile || name == kCheckpointFile ||
+            name == std::string(kCheckpointFile) + ".tmp") {
+            fs::remove(entry.path());
+        }
+    }
+    segments_.clear();
+    retired_.clear();
+    next_id_ = 1;
+    snapshot_id_ = 0;
+    visited_bytes_ = 0;
+    pending_ = 0;
+}
+
+bool FrontierStore::resume(const std::function<void(std::uint64_t)>& visited) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ifstream manifest(dir_ / kCheckpointFile);
+    if (!manifest) {
+        return false;
+    }
+
+    std::deque<Segment> segments;
+    std::uint64_t visited_bytes = 0;
+    std::uint64_t next_id = 1;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "visited") {
+            fields >> visited_bytes;
+        }
+        else if (kind == "next") {
+            fields >> next_id;
+        }
+        else if (kind == "segment") {
+            Segment segment;
+            fields >> segment.id >> segment.offset >> segment.end >> segment.tasks;
+            segments.push_back(segment);
+        }
+        if (fields.fail()) {
+            throw std::runtime_error("Corrupt frontier checkpoint: " + line);
+        }
+    }
+
+    // Все, что дописано после точки, отбрасывается: отпечатки и задачи
+    // должны соответствовать друг другу
+    fs::path const visited_path = dir_ / kVisitedFile;
+    if (visited_bytes > 0) {
+        fs::resize_file(visited_path, visited_bytes);
+        ipc::file_mapping file(visited_path.string().c_str(), ipc::read_only);
+        ipc::mapped_region region(file, ipc::read_only, 0, visited_bytes);
+        const char* data = static_cast<const char*>(region.get_address());
+        for (std::uint64_t offset = 0; offset + sizeof(std::uint64_t) <= visited_bytes; offset += sizeof(std::uint64_t)) {
+            std::uint64_t fp;
+            std::memcpy(&fp, data + offset, sizeof(fp));
+            visited(fp);
+        }
+    }
+    else if (fs::exists(visited_path)) {
+        fs::resize_file(visited_path, 0);
+    }
+
+    std::size_t pending = 0;
+    for (const Segment& segment : segments) {
+        fs::resize_file(segment_path(segment.id), segment.end);
+        pending += segment.tasks;
+    }
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        std::uint64_t id;
+        if (parse_segment_id(entry.path(), id) && std::none_of(segments.begin(), segments.end(),
+            [id](const Segment& segment) { return segment.id == id; })) {
+            fs::remove(entry.path());
+        }
+    }
+
+    segments_ = std::move(segments);
+    retired_.clear();
+    next_id_ = next_id;
+    snapshot_id_ = 0; // Снимок прошлой точки читается как обычный сегмент
+    visited_bytes_ = visited_bytes;
+    pending_ = pending;
+    return true;
+}
+
+void FrontierStore::write_record(std::ofstream& out, const CrawlTask& task, Segment& segment) {
+    std::uint32_t const length = static_cast<std::uint32_t>(task.url.size());
+    std::int32_t const depth = task.depth;
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(reinterpret_cast<const char*>(&depth), sizeof(depth));
+    out.write(task.url.data(), length);
+    segment.end += sizeof(length) + sizeof(depth) + length;
+    segment.tasks++;
+}
+
+void FrontierStore::close_writer() {
+    if (writing_) {
+        writer_.close();
+        writing_ = false;
+    }
+}
+
+void FrontierStore::append(const CrawlTask& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!writing_) {
+        Segment segment;
+        segment.id = next_id_++;
+        writer_.open(segment_path(segment.id), std::ios::binary | std::ios::trunc);
+        if (!writer_) {
+            throw std::runtime_error("Cannot create frontier segment " + segment_path(segment.id).string());
+        }
+        segments_.push_back(segment);
+        writing_ = true;
+    }
+    write_record(writer_, task, segments_.back());
+    pending_++;
+    if (segments_.back().end >= kSegmentBytes) {
+        close_writer();
+    }
+}
+
+std::size_t FrontierStore::read(std::size_t max_bytes, std::vector<CrawlTask>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t bytes = 0;
+    std::size_t tasks = 0;
+    while (!segments_.empty() && bytes < max_bytes) {
+        Segment& segment = segments_.front();
+        bool const open = writing_ && segments_.size() == 1;
+        if (open) {
+            writer_.flush();
+        }
+
+        if (segment.offset < segment.end) {
+            ipc::file_mapping file(segment_path(segment.id).string().c_str(), ipc::read_only);
+            ipc::mapped_region region(file, ipc::read_only, segment.offset, segment.end - segment.offset);
+            const char* const data = static_cast<const char*>(region.get_address());
+            std::size_t position = 0;
+            std::size_t const size = region.get_size();
+            while (position < size && bytes < max_bytes) {
+                std::uint32_t length;
+                std::int32_t depth;
+                std::memcpy(&length, data + position, sizeof(length));
+                std::memcpy(&depth, data + position + sizeof(length), sizeof(depth));
+                position += sizeof(length) + sizeof(depth);
+                out.push_back(CrawlTask{ std::string(data + position, length), depth });
+                position += length;
+                bytes += length;
+                tasks++;
+                segment.tasks--;
+            }
+            segment.offset += position;
+        }
+
+        if (segment.offset < segment.end || open) {
+            break;
+        }
+        // Файл нужен, пока на него ссылается записанная контрольная точка
+        retired_.push_back(segment.id);
+        segments_.pop_front();
+    }
+    pending_ -= tasks;
+    return tasks;
+}
+
+void FrontierStore::checkpoint(const std::vector<CrawlTask>& snapshot, const std::vector<std::uint64_t>& visited) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_writer();
+
+    std::uint64_t const snapshot_id = next_id_++;
+    Segment snapshot_segment;
+    snapshot_segment.id = snapshot_id;
+    {
+        std::ofstream out(segment_path(snapshot_id), std::ios::binary | std::ios::trunc);
+        for (const CrawlTask& task : snapshot) {
+            write_record(out, task, snapshot_segment);
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("Cannot write frontier snapshot");
+        }
+    }
+    {
+        std::ofstream out(dir_ / kVisitedFile, std::ios::binary | std::ios::app);
+        out.write(reinterpret_cast<const char*>(visited.data()), visited.size() * sizeof(std::uint64_t));
+        if (!out.flush()) {
+            throw std::runtime_error("Cannot append to the visited log");
+        }
+        visited_bytes_ += visited.size() * sizeof(std::uint64_t);
+    }
+
+    // Сначала снимок того, что в памяти, затем непрочитанные хвосты на диске
+    fs::path const temporary = dir_ / (std::string(kCheckpointFile) + ".tmp");
+    {
+        std::ofstream manifest(temporary, std::ios::trunc);
+        manifest << "visited " << visited_bytes_ << "\n";
+        manifest << "next " << next_id_ << "\n";
+        manifest << "segment " << snapshot_segment.id << " 0 " << snapshot_segment.end << " " << snapshot_segment.tasks << "\n";
+        for (const Segment& segment : segments_) {
+            manifest << "segment " << segment.id << " " << segment.offset << " " << segment.end << " " << segment.tasks << "\n";
+        }
+        if (!manifest.flush()) {
+            throw std::runtime_error("Cannot write frontier checkpoint");
+        }
+    }
+    // Манифест подменяется, только когда все, на что он ссылается, уже на диске
+    sync_file(segment_path(snapshot_id));
+    for (const Segment& segment : segments_) {
+        sync_file(segment_path(segment.id));
+    }
+    sync_file(dir_ / kVisitedFile);
+    sync_file(temporary);
+    fs::rename(temporary, dir_ / kCheckpointFile);
+    sync_directory(dir_);
+
+    if (snapshot_id_ != 0) {
+        remove_segment(snapshot_id_);
+    }
+    for (std::uint64_t id : retired_) {
+        remove_segment(id);
+    }
+    retired_.clear();
+    snapshot_id_ = snapshot_id;
+}
+
+void FrontierStore::remove_segment(std::uint64_t id) {
+    std::error_code ec;
+    fs::remove(segment_path(id), ec);
+    if (ec) {
+        std::cerr << "Cannot remove frontier segment " << id << ": " << ec.message() << std::endl;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef FRONTIER_STORE_H
+#define FRONTIER_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "frontier.h"
+
+// Состояние обхода на диске, в каталоге spider.frontier_dir:
+//   segment-N.seg - задачи, вытесненные из памяти, и снимки границы; файлы только дописываются;
+//   visited.log   - отпечатки посещенных URL в порядке добавления;
+//   checkpoint    - последняя контрольная точка, заменяется атомарно через rename.
+// Запись сегмента: длина URL (4 байта), глубина (4 байта), байты URL.
+// Сегменты читаются через отображение файла в память.
+class FrontierStore {
+public:
+    explicit FrontierStore(std::filesystem::path dir);
+
+    // Новый обход: старое состояние удаляется
+    void reset();
+
+    // Восстанавливает контрольную точку: отпечатки передаются в visited,
+    // задачи остаются на диске до чтения. false, если точки нет.
+    bool resume(const std::function<void(std::uint64_t)>& visited);
+
+    void append(const CrawlTask& task);
+
+    // Читает задачи из сегментов по порядку, пока не наберется max_bytes URL
+    std::size_t read(std::size_t max_bytes, std::vector<CrawlTask>& out);
+
+    // Задачи на диске, еще не прочитанные в память
+    std::size_t pending() const { return pending_; }
+
+    // Записывает контрольную точку: snapshot - все задачи в памяти,
+    // visited - отпечатки, добавленные с прошлой точки
+    void checkpoint(const std::vector<CrawlTask>& snapshot, const std::vector<std::uint64_t>& visited);
+
+private:
+    struct Segment {
+        std::uint64_t id = 0;
+        std::uint64_t offset = 0; // Начало непрочитанных записей
+        std::uint64_t end = 0;    // Конец записанных данных
+        std::size_t tasks = 0;    // Непрочитанных задач
+    };
+
+    std::filesystem::path segment_path(std::uint64_t id) const;
+    void write_record(std::ofstream& out, const CrawlTask& task, Segment& segment);
+    void close_writer();
+    void remove_segment(std::uint64_t id);
+
+    std::filesystem::path dir_;
+    mutable std::mutex mutex_;
+    std::deque<Segment> segments_; // Очередь чтения; последний может быть открыт на запись
+    std::ofstream writer_;
+    bool writing_ = false;
+    std::uint64_t next_id_ = 1;
+    std::uint64_t snapshot_id_ = 0;      // Снимок последней точки, его задачи сейчас в памяти
+    std::vector<std::uint64_t> retired_; // Прочитанные сегменты, нужные прошлой точке
+    std::uint64_t visited_bytes_ = 0;
+    std::atomic<std::size_t> pending_{ 0 };
+};
+
+#endif // FRONTIER_STORE_H
@@ -0,0 +1,44 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 64-битный MurmurHash64A: отпечатки URL и содержимого страниц
+inline std::uint64_t hash64(std::string_view data, std::uint64_t seed = 0) {
+    constexpr std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+    constexpr int r = 47;
+
+    std::uint64_t h = seed ^ (data.size() * m);
+    const char* p = data.data();
+    const char* const end = p + (data.size() & ~std::size_t(7));
+
+    for (; p != end; p += 8) {
+        std::uint64_t k;
+        std::memcpy(&k, p, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (data.size() & 7) {
+    case 7: h ^= std::uint64_t(static_cast<unsigned char>(p[6])) << 48; [[fallthrough]];
+    case 6: h ^= std::uint64_t(static_cast<unsigned char>(p[5])) << 40; [[fallthrough]];
+    case 5: h ^= std::uint64_t(static_cast<unsigned char>(p[4])) << 32; [[fallthrough]];
+    case 4: h ^= std::uint64_t(static_cast<unsigned char>(p[3])) << 24; [[fallthrough]];
+    case 3: h ^= std::uint64_t(static_cast<unsigned char>(p[2])) << 16; [[fallthrough]];
+    case 2: h ^= std::uint64_t(static_cast<unsigned char>(p[1])) << 8; [[fallthrough]];
+    case 1: h ^= std::uint64_t(static_cast<unsigned char>(p[0]));
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+#endif // HASH_H
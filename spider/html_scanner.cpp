@@ -0,0 +1,270 @@
+#include "html_scanner.h"
+#include <cstdint>
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool is_alnum(char c) {
+    return is_alpha(c) || (c >= '0' && c <= '9');
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c + ('a' - 'A'));
+        }
+        if (c != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void append_utf8(std::uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+struct NamedEntity {
+    std::string_view name;
+    std::uint32_t code;
+};
+
+// Неразрывный пробел декодируется в обычный: для индекса это разделитель слов
+constexpr NamedEntity kEntities[] = {
+    { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+    { "nbsp", ' ' }, { "copy", 0xA9 }, { "reg", 0xAE }, { "deg", 0xB0 }, { "middot", 0xB7 },
+    { "laquo", 0xAB }, { "raquo", 0xBB }, { "times", 0xD7 }, { "ndash", 0x2013 }, { "mdash", 0x2014 },
+    { "lsquo", 0x2018 }, { "rsquo", 0x2019 }, { "ldquo", 0x201C }, { "rdquo", 0x201D },
+    { "bull", 0x2022 }, { "hellip", 0x2026 }, { "euro", 0x20AC }, { "trade", 0x2122 },
+};
+
+// Декодирует сущность в начале input (input[0] == '&'). Возвращает длину сущности или 0.
+std::size_t decode_entity(std::string_view input, std::string& out) {
+    if (input.size() > 2 && input[1] == '#') {
+        bool const hex = input[2] == 'x' || input[2] == 'X';
+        std::size_t pos = hex ? 3 : 2;
+        std::uint32_t cp = 0;
+        std::size_t digits = 0;
+        for (; pos < input.size() && digits < 8; ++pos, ++digits) {
+            char const c = input[pos];
+            if (c >= '0' && c <= '9') {
+                cp = cp * (hex ? 16 : 10) + (c - '0');
+            }
+            else if (hex && ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+                cp = cp * 16 + ((c | 0x20) - 'a' + 10);
+            }
+            else {
+                break;
+            }
+        }
+        if (digits == 0) {
+            return 0;
+        }
+        if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            cp = 0xFFFD;
+        }
+        append_utf8(cp, out);
+        return pos < input.size() && input[pos] == ';' ? pos + 1 : pos;
+    }
+
+    std::size_t end = 1;
+    while (end < input.size() && end <= 8 && is_alnum(input[end])) {
+        ++end;
+    }
+    if (end >= input.size() || input[end] != ';') {
+        return 0;
+    }
+    std::string_view const name = input.substr(1, end - 1);
+    for (const auto& entity : kEntities) {
+        if (entity.name == name) {
+            append_utf8(entity.code, out);
+            return end + 1;
+        }
+    }
+    return 0;
+}
+
+// Разбирает атрибуты тега начиная с pos; возвращает позицию после '>'.
+// Если links не нулевой, собирает в него значения href.
+std::size_t scan_attributes(std::string_view html, std::size_t pos, std::vector<std::string>* links) {
+    std::size_t const n = html.size();
+    while (pos < n) {
+        while (pos < n && (is_space(html[pos]) || html[pos] == '/')) {
+            ++pos;
+        }
+        if (pos >= n) {
+            break;
+        }
+        if (html[pos] == '>') {
+            return pos + 1;
+        }
+
+        std::size_t const name_start = pos;
+        while (pos < n && !is_space(html[pos]) && html[pos] != '=' && html[pos] != '>' && html[pos] != '/') {
+            ++pos;
+        }
+        std::string_view const name = html.substr(name_start, pos - name_start);
+
+        while (pos < n && is_space(html[pos])) {
+            ++pos;
+        }
+        if (pos >= n || html[pos] != '=') {
+            continue;
+        }
+        ++pos;
+        while (pos < n && is_space(html[pos])) {
+            ++pos;
+        }
+        if (pos >= n) {
+            break;
+        }
+
+        std::string_view value;
+        if (html[pos] == '"' || html[pos] == '\'') {
+            std::size_t const close = html.find(html[pos], pos + 1);
+            std::size_t const value_end = close == std::string_view::npos ? n : close;
+            value = html.substr(pos + 1, value_end - pos - 1);
+            pos = close == std::string_view::npos ? n : close + 1;
+        }
+        else {
+            std::size_t const value_start = pos;
+            while (pos < n && !is_space(html[pos]) && html[pos] != '>') {
+                ++pos;
+            }
+            value = html.substr(value_start, pos - value_start);
+        }
+
+        if (links && iequals(name, "href")) {
+            std::string link;
+            append_decoded(value, link);
+            std::size_t const first = link.find_first_not_of(" \t\r\n");
+            std::size_t const last = link.find_last_not_of(" \t\r\n");
+            links->push_back(first == std::string::npos ? std::string() : link.substr(first, last - first + 1));
+        }
+    }
+    return n;
+}
+
+// Пропускает сырой текст <script>/<style> до закрывающего тега
+std::size_t skip_raw_text(std::string_view html, std::size_t pos, std::string_view tag) {
+    while (true) {
+        std::size_t const close = html.find("</", pos);
+        if (close == std::string_view::npos) {
+            return html.size();
+        }
+        if (iequals(html.substr(close + 2, tag.size()), tag)) {
+            std::size_t const end = html.find('>', close);
+            return end == std::string_view::npos ? html.size() : end + 1;
+        }
+        pos = close + 2;
+    }
+}
+
+std::size_t skip_past(std::string_view html, std::size_t pos, std::string_view terminator) {
+    std::size_t const end = html.find(terminator, pos);
+    return end == std::string_view::npos ? html.size() : end + terminator.size();
+}
+
+} // namespace
+
+void append_decoded(std::string_view input, std::string& out) {
+    while (!input.empty()) {
+        std::size_t const amp = input.find('&');
+        out.append(input.substr(0, amp));
+        if (amp == std::string_view::npos) {
+            break;
+        }
+        input.remove_prefix(amp);
+        std::size_t used = decode_entity(input, out);
+        if (used == 0) {
+            out += '&';
+            used = 1;
+        }
+        input.remove_prefix(used);
+    }
+}
+
+void scan_html(std::string_view html, ParsedHtml& out) {
+    out.clear();
+    out.text.reserve(html.size() / 2);
+
+    std::size_t const n = html.size();
+    std::size_t pos = 0;
+    while (pos < n) {
+        std::size_t const lt = html.find('<', pos);
+        if (lt == std::string_view::npos) {
+            append_decoded(html.substr(pos), out.text);
+            break;
+        }
+        append_decoded(html.substr(pos, lt - pos), out.text);
+        pos = lt + 1;
+        if (pos >= n) {
+            break;
+        }
+
+        // Комментарии, <!DOCTYPE>, <![CDATA[...]]> и инструкции обработки
+        if (html[pos] == '!' || html[pos] == '?') {
+            if (html.compare(pos, 3, "!--") == 0) {
+                pos = skip_past(html, pos + 3, "-->");
+            }
+            else if (html.compare(pos, 8, "![CDATA[") == 0) {
+                pos = skip_past(html, pos + 8, "]]>");
+            }
+            else {
+                pos = skip_past(html, pos, ">");
+            }
+            out.text += ' ';
+            continue;
+        }
+
+        bool const closing = html[pos] == '/';
+        std::size_t const name_start = closing ? pos + 1 : pos;
+        if (name_start >= n || !is_alpha(html[name_start])) {
+            // Одиночный '<' в тексте
+            out.text += '<';
+            continue;
+        }
+
+        pos = name_start;
+        while (pos < n && !is_space(html[pos]) && html[pos] != '>' && html[pos] != '/') {
+            ++pos;
+        }
+        std::string_view const name = html.substr(name_start, pos - name_start);
+
+        bool const anchor = !closing && iequals(name, "a");
+        pos = scan_attributes(html, pos, anchor ? &out.links : nullptr);
+        out.text += ' ';
+
+        if (!closing && (iequals(name, "script") || iequals(name, "style"))) {
+            pos = skip_raw_text(html, pos, iequals(name, "script") ? "script" : "style");
+        }
+    }
+}
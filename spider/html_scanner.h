@@ -0,0 +1,26 @@
+#ifndef HTML_SCANNER_H
+#define HTML_SCANNER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Результат разбора страницы за один проход
+struct ParsedHtml {
+    std::vector<std::string> links; // Значения href тегов <a>, сущности декодированы
+    std::string text;               // Видимый текст; теги заменены пробелами
+
+    void clear() {
+        links.clear();
+        text.clear();
+    }
+};
+
+// Однопроходный сканер HTML без возвратов: собирает ссылки и видимый текст,
+// пропускает комментарии и содержимое <script>/<style>, декодирует сущности.
+void scan_html(std::string_view html, ParsedHtml& out);
+
+// Декодирует HTML-сущности фрагмента и дописывает результат в out
+void append_decoded(std::string_view input, std::string& out);
+
+#endif // HTML_SCANNER_H
@@ -0,0 +1,383 @@
+#include "http_client.h"
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/version.hpp>
+#include <iostream>
+#include "content_decoder.h"
+#include "url.h"
+#include <stdexcept>
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+namespace {
+
+constexpr int kMaxRedirects = 5;
+
+bool is_redirect(http::status status) {
+    return status == http::status::moved_permanently ||
+        status == http::status::found ||
+        status == http::status::see_other ||
+        status == http::status::temporary_redirect ||
+        status == http::status::permanent_redirect;
+}
+
+// Ответы с телом больше этого не дочитываются ради повторного использования соединения
+constexpr std::size_t kDrainLimit = 64 * 1024;
+
+using Parser = http::response_parser<http::buffer_body>;
+
+// Отправляет запрос и читает только заголовки ответа
+template <class Stream, class Request>
+net::awaitable<void> send_and_read_header(Stream& stream, beast::flat_buffer& buffer, const Request& req, Parser& parser,
+    boost::system::error_code& ec) {
+    co_await http::async_write(stream, req, net::redirect_error(net::use_awaitable, ec));
+    if (ec) {
+        co_return;
+    }
+    co_await http::async_read_header(stream, buffer, parser, net::redirect_error(net::use_awaitable, ec));
+}
+
+// Читает тело кусками в буфер на стеке и передает их в sink(data, size).
+// Если sink вернул false, чтение прекращается и соединение нельзя переиспользовать.
+template <class Stream, class Sink>
+net::awaitable<void> read_body(Stream& stream, beast::flat_buffer& buffer, Parser& parser, Sink sink,
+    boost::system::error_code& ec) {
+    char chunk[16 * 1024];
+    while (!parser.is_done()) {
+        parser.get().body().data = chunk;
+        parser.get().body().size = sizeof(chunk);
+        co_await http::async_read(stream, buffer, parser, net::redirect_error(net::use_awaitable, ec));
+        if (ec == http::error::need_buffer) {
+            ec = {};
+        }
+        if (ec) {
+            co_return;
+        }
+        if (!sink(chunk, sizeof(chunk) - parser.get().body().size)) {
+            co_return;
+        }
+    }
+}
+
+// Значение заголовка в виде std::string_view (beast::string_view в разных версиях Boost разный)
+std::string_view field_value(const http::fields& fields, http::field name) {
+    auto const value = fields[name];
+    return { value.data(), value.size() };
+}
+
+bool is_html(std::string_view content_type) {
+    std::size_t const end = content_type.find(';');
+    std::string type;
+    for (char c : content_type.substr(0, end)) {
+        if (c != ' ' && c != '\t') {
+            type += static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        }
+    }
+    // Без Content-Type страница разбирается, как раньше
+    return type.empty() || type == "text/html" || type == "application/xhtml+xml";
+}
+
+} // namespace
+
+bool decode_archived_response(std::string_view message, std::size_t max_body_bytes, FetchResult& result,
+    std::string& skipped) {
+    http::response_parser<http::string_body> parser;
+    parser.eager(true);
+    parser.body_limit(max_body_bytes);
+    boost::system::error_code ec;
+    std::size_t offset = 0;
+    while (!parser.is_done()) {
+        if (offset >= message.size()) {
+            // Тело без длины заканчивается вместе с блоком
+            parser.put_eof(ec);
+        }
+        else {
+            offset += parser.put(net::buffer(message.data() + offset, message.size() - offset), ec);
+            if (ec == http::error::need_more) {
+                ec = {};
+            }
+        }
+        if (ec) {
+            skipped = "malformed HTTP response: " + ec.message();
+            return false;
+        }
+    }
+
+    const auto& header = parser.get();
+    result.status = static_cast<int>(header.result());
+    if (header.result() != http::status::ok) {
+        skipped = "status " + std::to_string(result.status);
+        return false;
+    }
+    if (!is_html(field_value(header, http::field::content_type))) {
+        skipped = "not HTML (" + std::string(field_value(header, http::field::content_type)) + ")";
+        return false;
+    }
+
+    ContentDecoder decoder;
+    if (!decoder.reset(field_value(header, http::field::content_encoding), max_body_bytes)) {
+        skipped = "unsupported Content-Encoding " + std::string(field_value(header, http::field::content_encoding));
+        return false;
+    }
+    const std::string& body = parser.get().body();
+    result.body.clear();
+    decoder.write(body.data(), body.size(), result.body);
+    decoder.finish();
+    result.content_type = std::string(field_value(header, http::field::content_type));
+    result.etag = std::string(field_value(header, http::field::etag));
+    result.last_modified = std::string(field_value(header, http::field::last_modified));
+    return true;
+}
+
+HttpClient::HttpClient(ssl::context& ssl_ctx, const Config& config)
+    : ssl_ctx_(ssl_ctx), timeout_(config.request_timeout_seconds),
+    max_body_bytes_(static_cast<std::size_t>(config.max_body_bytes)), pool_(config), dns_(config) {
+}
+
+net::awaitable<FetchResult> HttpClient::fetch(std::string url, std::string_view etag, std::string_view last_modified) {
+    FetchResult result;
+    for (int redirects = 0; redirects <= kMaxRedirects; ++redirects) {
+        try {
+            Response res = co_await request(url, etag, last_modified);
+            result.status = static_cast<int>(res.status);
+
+            if (res.status == http::status::not_modified) {
+                result.url = url;
+                result.not_modified = true;
+                co_return result;
+            }
+
+            if (is_redirect(res.status)) {
+                if (res.location.empty()) {
+                    std::cerr << "Redirected without a new location" << std::endl;
+                    co_return result;
+                }
+                // Location может быть относительным
+                UrlParts base;
+                std::string next;
+                if (!parse_url(url, base) || !resolve_url(base, res.location, next)) {
+                    std::cerr << "Redirected to an unsupported location: " << res.location << std::endl;
+                    co_return result;
+                }
+                url = std::move(next);
+                // Валидаторы относятся к исходному URL
+                etag = {};
+                last_modified = {};
+                continue;
+            }
+
+            if (res.status != http::status::ok) {
+                std::cerr << "HTTP request failed: " << result.status << " " << http::obsolete_reason(res.status) << std::endl;
+                co_return result;
+            }
+
+            if (!res.skipped.empty()) {
+                std::cerr << "Skipping " << url << ": " << res.skipped << std::endl;
+                co_return result;
+            }
+
+            result.url = url;
+            result.body = std::move(res.body);
+            result.content_type = std::move(res.content_type);
+            result.etag = std::move(res.etag);
+            result.last_modified = std::move(res.last_modified);
+            co_return result;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error fetching page " << url << ": " << e.what() << std::endl;
+            co_return result;
+        }
+    }
+
+    std::cerr << "Too many redirects for URL: " << url << std::endl;
+    co_return result;
+}
+
+net::awaitable<HttpClient::Response> HttpClient::request(const std::string& url, std::string_view etag,
+    std::string_view last_modified) {
+    // URL приходят в канонической форме (url.h): схема и хост в нижнем регистре, путь не пустой
+    UrlParts parts;
+    if (!parse_url(url, parts) || !parts.has_authority || parts.host.empty()) {
+        throw std::invalid_argument("Invalid URL: " + url);
+    }
+    std::string const scheme(parts.scheme);
+    if (scheme != "http" && scheme != "https") {
+        throw std::invalid_argument("Unsupported URL scheme: " + scheme);
+    }
+
+    std::string host(parts.host);
+    std::string hostname = host;
+    if (hostname.size() > 2 && hostname.front() == '[') {
+        hostname = hostname.substr(1, hostname.size() - 2);
+    }
+    // Порт, если указан явно, иначе сервис по схеме
+    std::string const service = parts.port.empty() ? scheme : std::string(parts.port);
+    if (!parts.port.empty()) {
+        host += ':';
+        host.append(parts.port);
+    }
+
+    std::string target(parts.path.empty() ? "/" : parts.path);
+    if (parts.has_query) {
+        target += '?';
+        target.append(parts.query);
+    }
+
+    http::request<http::empty_body> req{ http::verb::get, target, 11 };
+    req.set(http::field::host, host);
+    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    req.set(http::field::accept, "text/html,application/xhtml+xml;q=0.9,*/*;q=0.1");
+    req.set(http::field::accept_encoding, ContentDecoder::accept_encoding());
+    if (!etag.empty()) {
+        req.set(http::field::if_none_match, std::string(etag));
+    }
+    if (!last_modified.empty()) {
+        req.set(http::field::if_modified_since, std::string(last_modified));
+    }
+    req.keep_alive(true);
+
+    std::string const key = scheme + "://" + host;
+    for (int attempt = 0; ; ++attempt) {
+        auto conn = pool_.acquire(key);
+        bool const reused = conn != nullptr;
+        if (!conn) {
+            conn = co_await connect(key, scheme, hostname, service);
+        }
+
+        // Сначала читаются только заголовки: по ним решается, нужно ли тело
+        Parser parser;
+        parser.body_limit(max_body_bytes_);
+        boost::system::error_code ec;
+        conn->lowest_layer().expires_after(timeout_);
+        if (conn->secure) {
+            co_await send_and_read_header(*conn->secure, conn->buffer, req, parser, ec);
+        }
+        else {
+            co_await send_and_read_header(*conn->plain, conn->buffer, req, parser, ec);
+        }
+
+        if (ec) {
+            // Сервер мог закрыть простаивающее соединение: повторяем на новом
+            if (reused && attempt == 0) {
+                pool_.record_stale();
+                continue;
+            }
+            throw boost::system::system_error{ ec };
+        }
+
+        // К этому моменту получены и билеты TLS 1.3, сессию можно сохранить
+        if (conn->secure && !reused) {
+            pool_.store_session(key, conn->secure->native_handle());
+        }
+
+        Response res;
+        const auto& header = parser.get();
+        res.status = header.result();
+        bool reusable = parser.keep_alive();
+
+        if (res.status == http::status::ok) {
+            // Не HTML и заведомо слишком большие ответы обрываются на заголовках,
+            // соединение при этом закрывается
+            if (!is_html(field_value(header, http::field::content_type))) {
+                res.skipped = "not HTML (" + std::string(field_value(header, http::field::content_type)) + ")";
+            }
+            else if (parser.content_length() && *parser.content_length() > max_body_bytes_) {
+                res.skipped = "body of " + std::to_string(*parser.content_length()) + " bytes exceeds the limit";
+            }
+            if (!res.skipped.empty()) {
+                skipped_++;
+                co_return res;
+            }
+
+            ContentDecoder decoder;
+            if (!decoder.reset(field_value(header, http::field::content_encoding), max_body_bytes_)) {
+                skipped_++;
+                res.skipped = "unsupported Content-Encoding " + std::string(field_value(header, http::field::content_encoding));
+                co_return res;
+            }
+            res.content_type = std::string(field_value(header, http::field::content_type));
+            res.etag = std::string(field_value(header, http::field::etag));
+            res.last_modified = std::string(field_value(header, http::field::last_modified));
+            if (parser.content_length()) {
+                res.body.reserve(static_cast<std::size_t>(*parser.content_length()));
+            }
+
+            auto sink = [&](const char* data, std::size_t size) {
+                wire_bytes_ += size;
+                decoder.write(data, size, res.body);
+                return true;
+            };
+            if (conn->secure) {
+                co_await read_body(*conn->secure, conn->buffer, parser, sink, ec);
+            }
+            else {
+                co_await read_body(*conn->plain, conn->buffer, parser, sink, ec);
+            }
+            if (!ec) {
+                decoder.finish();
+            }
+            decoded_bytes_ += res.body.size();
+        }
+        else {
+            res.location = std::string(field_value(header, http::field::location));
+
+            // Короткое тело редиректа или ошибки дочитывается, чтобы вернуть соединение в пул
+            std::size_t drained = 0;
+            auto sink = [&](const char*, std::size_t size) {
+                drained += size;
+                return drained <= kDrainLimit;
+            };
+            if (conn->secure) {
+                co_await read_body(*conn->secure, conn->buffer, parser, sink, ec);
+            }
+            else {
+                co_await read_body(*conn->plain, conn->buffer, parser, sink, ec);
+            }
+        }
+
+        if (ec) {
+            throw boost::system::system_error{ ec };
+        }
+        if (reusable && parser.is_done()) {
+            pool_.release(std::move(conn));
+        }
+        co_return res;
+    }
+}
+
+net::awaitable<std::unique_ptr<PooledConnection>> HttpClient::connect(const std::string& key, const std::string& scheme,
+    const std::string& hostname, const std::string& service) {
+    auto executor = co_await net::this_coro::executor;
+    auto const results = co_await dns_.resolve(hostname, service);
+
+    auto conn = std::make_unique<PooledConnection>();
+    conn->key = key;
+    if (scheme == "https") {
+        conn->secure = std::make_unique<beast::ssl_stream<beast::tcp_stream>>(executor, ssl_ctx_);
+        SSL* ssl = conn->secure->native_handle();
+        if (!SSL_set_tlsext_host_name(ssl, hostname.c_str())) {
+            boost::system::error_code ec{ static_cast<int>(::ERR_get_error()), net::error::get_ssl_category() };
+            throw boost::system::system_error{ ec };
+        }
+        pool_.apply_session(key, ssl);
+
+        conn->lowest_layer().expires_after(timeout_);
+        co_await conn->lowest_layer().async_connect(results, net::use_awaitable);
+        co_await conn->secure->async_handshake(ssl::stream_base::client, net::use_awaitable);
+        pool_.record_handshake(ssl);
+    }
+    else {
+        conn->plain = std::make_unique<beast::tcp_stream>(executor);
+        conn->plain->expires_after(timeout_);
+        co_await conn->plain->async_connect(results, net::use_awaitable);
+    }
+    co_return conn;
+}
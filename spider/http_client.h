@@ -0,0 +1,79 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/http.hpp>
+#include "../config/config.h"
+#include "connection_pool.h"
+#include "dns_cache.h"
+
+// Результат загрузки страницы
+struct FetchResult {
+    std::string url;   // итоговый URL после редиректов
+    int status = 0;
+    std::string body;
+    std::string content_type;  // Из него берется кодировка страницы
+    std::string etag;          // Валидаторы для следующего условного запроса
+    std::string last_modified;
+    bool not_modified = false; // 304: страница не изменилась с прошлого обхода
+};
+
+// Разбирает сохраненный HTTP-ответ (блок записи WARC): снимает chunked и
+// Content-Encoding так же, как при загрузке. true, если это 200 с HTML;
+// иначе в skipped записывается причина.
+bool decode_archived_response(std::string_view message, std::size_t max_body_bytes, FetchResult& result,
+    std::string& skipped);
+
+// Асинхронный HTTP/HTTPS-клиент на общем io_context паука
+class HttpClient {
+public:
+    HttpClient(boost::asio::ssl::context& ssl_ctx, const Config& config);
+
+    // Загружает страницу, следуя редиректам. При ошибке возвращает пустое тело.
+    // Если переданы валидаторы, запрос условный (If-None-Match / If-Modified-Since).
+    boost::asio::awaitable<FetchResult> fetch(std::string url, std::string_view etag = {},
+        std::string_view last_modified = {});
+
+    ConnectionPool::Stats pool_stats() const { return pool_.stats(); }
+    DnsCache::Stats dns_stats() const { return dns_.stats(); }
+
+    // Байты тел ответов: полученные по сети и после распаковки
+    std::size_t wire_bytes() const { return wire_bytes_; }
+    std::size_t decoded_bytes() const { return decoded_bytes_; }
+    std::size_t skipped_responses() const { return skipped_; }
+
+private:
+    // Ответ без лишних копий: тело распаковывается сразу в body
+    struct Response {
+        boost::beast::http::status status = boost::beast::http::status::unknown;
+        std::string location;
+        std::string content_type;
+        std::string etag;
+        std::string last_modified;
+        std::string body;
+        std::string skipped; // Причина, по которой тело не загружалось
+    };
+
+    boost::asio::awaitable<Response> request(const std::string& url, std::string_view etag, std::string_view last_modified);
+    boost::asio::awaitable<std::unique_ptr<PooledConnection>> connect(const std::string& key, const std::string& scheme,
+        const std::string& hostname, const std::string& service);
+
+    boost::asio::ssl::context& ssl_ctx_;
+    std::chrono::seconds timeout_;
+    std::size_t max_body_bytes_;
+    ConnectionPool pool_;
+    DnsCache dns_;
+
+    std::atomic<std::size_t> wire_bytes_{ 0 };
+    std::atomic<std::size_t> decoded_bytes_{ 0 };
+    std::atomic<std::size_t> skipped_{ 0 };
+};
+
+#endif // HTTP_CLIENT_H
@@ -0,0 +1,72 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Гистограмма задержек для перцентилей: логарифмические корзины по 8 на октаву
+// (погрешность до 12%), запись из любого потока без блокировок
+class LatencyHistogram {
+public:
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto const us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        buckets_[bucket(us > 0 ? static_cast<std::uint64_t>(us) : 0)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::size_t count() const {
+        std::size_t total = 0;
+        for (const auto& b : buckets_) {
+            total += b.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Верхняя граница корзины, в которую попал квантиль q (0..1), в миллисекундах
+    double percentile(double q) const {
+        std::size_t const total = count();
+        if (total == 0) {
+            return 0;
+        }
+        std::size_t const rank = static_cast<std::size_t>(q * (total - 1)) + 1;
+        std::size_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return upper_bound(i) / 1000.0;
+            }
+        }
+        return upper_bound(kBuckets - 1) / 1000.0;
+    }
+
+private:
+    static constexpr std::size_t kSubBuckets = 8;
+    static constexpr std::size_t kBuckets = kSubBuckets * 40; // До 2^41 мкс
+
+    // Значения меньше 8 мкс - по корзине на микросекунду, дальше 8 корзин на степень двойки
+    static std::size_t bucket(std::uint64_t us) {
+        if (us < kSubBuckets) {
+            return static_cast<std::size_t>(us);
+        }
+        int const exponent = std::bit_width(us) - 1; // >= 3
+        std::size_t const sub = static_cast<std::size_t>(us >> (exponent - 3)) & (kSubBuckets - 1);
+        std::size_t const index = kSubBuckets * static_cast<std::size_t>(exponent - 2) + sub;
+        return index < kBuckets ? index : kBuckets - 1;
+    }
+
+    static double upper_bound(std::size_t index) {
+        if (index < kSubBuckets) {
+            return static_cast<double>(index + 1);
+        }
+        std::size_t const exponent = index / kSubBuckets + 2;
+        std::size_t const sub = index % kSubBuckets;
+        return static_cast<double>((kSubBuckets + sub + 1) << (exponent - 3));
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+};
+
+#endif // LATENCY_HISTOGRAM_H
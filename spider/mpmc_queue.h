@@ -0,0 +1,149 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// Ограниченная очередь со многими производителями и потребителями
+// (схема Вьюкова): у каждой ячейки свой счетчик последовательности,
+// try_push/try_pop обходятся одним CAS без блокировок.
+// Ожидающие варианты спят на std::atomic::wait, пока очередь пуста/полна.
+template <class T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(std::size_t capacity)
+        : capacity_(std::bit_ceil(capacity < 2 ? 2 : capacity)),
+        mask_(capacity_ - 1),
+        cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    bool try_push(T& value) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            std::size_t const seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t const diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Очередь полна
+            }
+            else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value.emplace(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        pushes_.fetch_add(1, std::memory_order_release);
+        pushes_.notify_one();
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            std::size_t const seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t const diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Очередь пуста
+            }
+            else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(*cell->value);
+        cell->value.reset();
+        cell->sequence.store(pos + capacity_, std::memory_order_release);
+
+        pops_.fetch_add(1, std::memory_order_release);
+        pops_.notify_one();
+        return true;
+    }
+
+    // Ждет свободного места; false, если очередь закрыта
+    bool push_wait(T& value) {
+        while (true) {
+            std::uint32_t const seen = pops_.load(std::memory_order_acquire);
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (try_push(value)) {
+                return true;
+            }
+            pops_.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    // Ждет элемента; false, если очередь закрыта и пуста
+    bool pop_wait(T& out) {
+        while (true) {
+            std::uint32_t const seen = pushes_.load(std::memory_order_acquire);
+            if (try_pop(out)) {
+                return true;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            pushes_.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    // Будит всех ожидающих; оставшиеся элементы еще можно забрать
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        pushes_.fetch_add(1, std::memory_order_release);
+        pushes_.notify_all();
+        pops_.fetch_add(1, std::memory_order_release);
+        pops_.notify_all();
+    }
+
+    // Приблизительная глубина очереди, для статистики
+    std::size_t size() const {
+        std::size_t const tail = tail_.load(std::memory_order_relaxed);
+        std::size_t const head = head_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        std::optional<T> value;
+    };
+
+    std::size_t const capacity_;
+    std::size_t const mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    // Голова и хвост в разных строках кэша, чтобы производители и потребители не мешали друг другу
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };
+    alignas(64) std::atomic<std::size_t> head_{ 0 };
+    alignas(64) std::atomic<std::uint32_t> pushes_{ 0 };
+    alignas(64) std::atomic<std::uint32_t> pops_{ 0 };
+    std::atomic<bool> closed_{ false };
+};
+
+#endif // MPMC_QUEUE_H
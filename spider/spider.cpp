@@ -1,298 +1,616 @@
 #include "spider.h"
-#include <boost/beast/core.hpp>
-#include <boost/beast/http.hpp>
-#include <boost/beast/version.hpp>
-#include <boost/asio/connect.hpp>
-#include <boost/asio/ip/tcp.hpp>
+#include "hash.h"
+#include "tokenizer.h"
+#include "url.h"
+#include "warc_reader.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/ssl.hpp>
-#include <boost/locale.hpp>
-#include <regex>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <chrono>
 #include <condition_variable>
+#include <algorithm>
+#if defined(SEARCH_ENGINE_PARALLEL_STL)
 #include <execution>
+#endif
 
-namespace http = boost::beast::http;
 namespace net = boost::asio;
 namespace ssl = net::ssl;
-using tcp = net::ip::tcp;
 
 Spider::Spider(const Config& config, Database& db)
-    : config_(config), db_(db), ssl_ctx_(ssl::context::sslv23_client),
-    work_guard_(net::make_work_guard(ioc_)) {
+    : config_(config), db_(db), index_writer_(db, config), visited_(config), frontier_(config, config.frontier_partitions), duplicates_(config), document_store_(config),
+    default_charset_(charset_from_label(config.default_charset)), parse_queue_(config.parse_queue_size), index_queue_(config.index_queue_size), ssl_ctx_(ssl::context::sslv23_client),
+    work_guard_(net::make_work_guard(ioc_)), http_(ssl_ctx_, config_) {
+    ssl_ctx_.set_default_verify_paths();
+    if (default_charset_ == Charset::Unknown) {
+        std::cerr << "Unknown spider.default_charset '" << config.default_charset
+            << "', undeclared pages that are not UTF-8 will be repaired as UTF-8" << std::endl;
+    }
     std::cout << "Spider initialized." << std::endl;
 }
 
 Spider::~Spider() {
+    shutdown();
+}
+
+// Стадии останавливаются по порядку: загрузчики, затем разбор, затем запись,
+// чтобы страницы, уже стоящие в очередях, дошли до базы
+void Spider::shutdown() {
     stop_ = true;
-    cv_.notify_all(); //   
+    work_guard_.reset();
+    work_signal_.notify();
+    parse_space_.notify();
 
-    for (auto& thread : thread_pool_) {
+    for (auto& thread : io_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    parse_queue_.close();
+    for (auto& thread : parse_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    index_queue_.close();
+    for (auto& thread : index_threads_) {
         if (thread.joinable()) {
-            thread.join(); //    
+            thread.join();
         }
     }
 }
 
-void Spider::start() {
+void Spider::start(bool resume) {
     std::cout << "Spider starting..." << std::endl;
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        urls_.emplace(config_.start_url, 0);
+    auto const started = std::chrono::steady_clock::now();
+    if (resume && frontier_.resume(visited_)) {
+        // Границу и посещенные URL восстановили, начальный URL уже обработан или в ней.
+        // Восстановленные отпечатки уже в visited.log, журнал включается после них
+        visited_.enable_journal();
+        pending_ += frontier_.size();
+        std::cout << "Resumed from checkpoint: " << frontier_.size() << " URLs in the frontier, "
+            << visited_.size() << " visited" << std::endl;
     }
-    cv_.notify_one();
-
-    for (size_t i = 0; i < config_.thread_count; ++i) {
-        thread_pool_.emplace_back([this]() {
+    else {
+        if (resume) {
+            std::cerr << "No frontier checkpoint to resume from, starting a new crawl" << std::endl;
+        }
+        frontier_.reset();
+        // Журнал включается до первой вставки: иначе начальный URL и URL из
+        // crawl_state не попадут в visited.log и после --resume загрузятся снова
+        if (frontier_.persistent()) {
+            visited_.enable_journal();
+        }
+        std::string start_url;
+        if (!normalize_url(config_.start_url, start_url)) {
+            std::cerr << "Invalid start URL: " << config_.start_url << std::endl;
+            start_url = config_.start_url;
+        }
+        visited_.insert(start_url);
+        enqueue_url(std::move(start_url), 0);
+        if (config_.incremental) {
+            seed_from_crawl_state();
+        }
+    }
+    int const parse_threads = config_.thread_count > 0
+        ? config_.thread_count : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < parse_threads; ++i) {
+        parse_threads_.emplace_back([this]() {
             try {
-                this->worker_thread();
+                this->parse_worker();
             }
             catch (const std::exception& e) {
-                std::cerr << "Exception in worker thread: " << e.what() << std::endl;
+                std::cerr << "Exception in parse thread: " << e.what() << std::endl;
             }
             });
     }
+    start_index_threads();
 
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        //       
+    // Сотни одновременных загрузок на нескольких потоках общего io_context.
+    // Каждый загрузчик на своем strand: WakeSignal отменяет его таймер через него
+    for (int i = 0; i < config_.max_concurrent_fetches; ++i) {
+        net::co_spawn(net::make_strand(ioc_), fetch_loop(i), net::detached);
     }
-
-    stop_ = true;
-    cv_.notify_all();
-
-    for (auto& thread : thread_pool_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
+    for (int i = 0; i < config_.io_thread_count; ++i) {
+        io_threads_.emplace_back([this]() {
+            try {
+                ioc_.run();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Exception in I/O thread: " << e.what() << std::endl;
+            }
+            });
     }
 
-    std::cout << "Spider finished." << std::endl;
-}
-
-void Spider::worker_thread() {
+    // Ждем, пока не будут обработаны все найденные URL, периодически печатая глубину очередей
+    // и сохраняя контрольные точки
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        active_threads_++;
-    }
-
-    while (true) {
-        std::pair<std::string, int> task;
-
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            cv_.wait(lock, [this]() { return !urls_.empty() || stop_; });
-
-            if (stop_ && urls_.empty()) {
-                active_threads_--;
-                if (active_threads_ == 0) {
-                    cv_.notify_all();
-                }
-                std::cout << "Worker thread exiting. Stop flag set and no more URLs." << std::endl;
-                return;
-            }
-
-            if (!urls_.empty()) {
-                task = urls_.front();
-                urls_.pop();
+        auto const interval = std::chrono::seconds(std::max(1, config_.stats_interval_seconds));
+        auto const checkpoint_interval = std::chrono::seconds(std::max(1, config_.checkpoint_interval_seconds));
+        auto last_checkpoint = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(done_mutex_);
+        while (!done_cv_.wait_for(lock, interval, [this]() { return pending_ == 0; })) {
+            report_pipeline();
+            if (frontier_.persistent() && std::chrono::steady_clock::now() - last_checkpoint >= checkpoint_interval) {
+                lock.unlock();
+                checkpoint();
+                lock.lock();
+                last_checkpoint = std::chrono::steady_clock::now();
             }
         }
+    }
 
-        if (task.first.empty()) {
-            continue;
-        }
-
-        auto [url, depth] = task;
-        std::cout << "Crawling URL: " << url << " at depth: " << depth << std::endl;
-
-        if (depth > config_.recursion_depth) {
-            continue;
-        }
-
-        {
-            std::lock_guard<std::mutex> lock(visited_mutex_);
-            if (visited_.find(url) != visited_.end()) {
-                continue;
-            }
-            visited_.insert(url);
-        }
+    shutdown();
+    index_writer_.flush();
+    if (frontier_.persistent()) {
+        // Обход завершен: пустая граница, повторный --resume ничего не загрузит
+        frontier_.checkpoint(visited_);
+    }
 
-        std::string content = fetch_page(ensure_scheme(url));
-        if (content.empty()) {
-            std::cerr << "Fetched content is empty for URL: " << url << std::endl;
-            continue;
-        }
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    run_seconds_ = seconds;
+    std::cout << "Fetched " << pages_fetched_ << " pages (" << bytes_fetched_ << " bytes) in "
+        << seconds << " s, " << (seconds > 0 ? pages_fetched_ / seconds : 0.0) << " pages/s, "
+        << pages_indexed_ << " indexed, fetchers stalled " << fetch_stalls_ << " times" << std::endl;
+    std::cout << "Fetch latency: p50 " << fetch_latency_.percentile(0.5) << " ms, p99 "
+        << fetch_latency_.percentile(0.99) << " ms over " << fetch_latency_.count() << " requests" << std::endl;
+    if (config_.incremental) {
+        std::cout << "Recrawl: " << crawl_state_.size() << " known pages, " << not_modified_ << " not modified (304), "
+            << unchanged_ << " unchanged by hash" << std::endl;
+    }
+    std::cout << "Frontier: " << frontier_.steals() << " tasks stolen between partitions" << std::endl;
+    auto const pool = http_.pool_stats();
+    std::cout << "Connection pool: " << pool.hits << " hits, " << pool.misses << " misses, "
+        << pool.stale << " stale, " << pool.evicted << " evicted over the idle limits; TLS sessions resumed " << pool.tls_resumed << " of "
+        << pool.tls_handshakes << " handshakes" << std::endl;
+    auto const dns = http_.dns_stats();
+    std::size_t const lookups = dns.hits + dns.misses + dns.coalesced;
+    std::cout << "DNS cache: " << dns.hits << " hits, " << dns.coalesced << " coalesced, " << dns.misses
+        << " lookups (" << dns.failures << " failed, " << dns.timeouts << " timed out), hit rate "
+        << (lookups ? 100.0 * (dns.hits + dns.coalesced) / lookups : 0.0) << "%, " << dns.evicted << " expired evicted"
+        << std::endl;
+    std::cout << "Transfer: " << http_.wire_bytes() / 1024 << " KiB on the wire, " << http_.decoded_bytes() / 1024
+        << " KiB decoded, " << http_.skipped_responses() << " responses skipped on headers" << std::endl;
+    report_totals();
+}
 
-        std::cout << "Processing content for URL: " << url << std::endl;
-        //     
-        // std::cout << "Content snippet: " << content.substr(0, 1000) << "..." << std::endl;
+Spider::Stats Spider::stats() const {
+    Stats stats;
+    stats.seconds = run_seconds_;
+    stats.pages_fetched = pages_fetched_;
+    stats.bytes_fetched = bytes_fetched_;
+    stats.pages_indexed = pages_indexed_;
+    stats.fetch_p50_ms = fetch_latency_.percentile(0.5);
+    stats.fetch_p99_ms = fetch_latency_.percentile(0.99);
+    stats.index = index_writer_.stats();
+    return stats;
+}
 
-        if (depth < config_.recursion_depth) {
-            std::vector<std::string> links;
+void Spider::start_index_threads() {
+    for (int i = 0; i < std::max(1, config_.index_threads); ++i) {
+        index_threads_.emplace_back([this]() {
             try {
-                //   URL  
-                links = extract_links(content, url);
+                this->index_worker();
             }
             catch (const std::exception& e) {
-                std::cerr << "Exception while extracting links: " << e.what() << std::endl;
-                continue;
+                std::cerr << "Exception in index thread: " << e.what() << std::endl;
             }
+            });
+    }
+}
 
-            for (const std::string& link : links) {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                if (visited_.find(link) == visited_.end()) {
-                    urls_.emplace(link, depth + 1);
-                    cv_.notify_one();
-                }
+// Переиндексация из WARC-файлов без сети. Записи читаются пачками, каждая пачка
+// разбирается параллельным алгоритмом на всех ядрах, запись в базу идет обычной стадией.
+void Spider::ingest(const std::vector<std::string>& files) {
+    std::cout << "Spider ingesting " << files.size() << " WARC files..." << std::endl;
+    auto const started = std::chrono::steady_clock::now();
+    offline_ = true;
+    start_index_threads();
+
+    std::size_t const batch_size = static_cast<std::size_t>(std::max(1, config_.parse_queue_size));
+    std::size_t const max_body = static_cast<std::size_t>(config_.max_body_bytes);
+    std::size_t records = 0;
+    std::size_t skipped = 0;
+    std::size_t archive_bytes = 0;
+    std::vector<FetchedPage> batch;
+    batch.reserve(batch_size);
+#if defined(SEARCH_ENGINE_PARALLEL_STL)
+    std::cout << "Parsing archived pages with parallel algorithms" << std::endl;
+    auto process_batch = [&]() {
+        std::for_each(std::execution::par, batch.begin(), batch.end(), [this](const FetchedPage& page) {
+            process_page(page);
+            });
+        batch.clear();
+    };
+#else
+    // Без TBB параллельный std::for_each в libstdc++ выполняется в одном потоке,
+    // поэтому пачку разбирают свои потоки, беря страницы по счетчику
+    std::size_t const threads = config_.thread_count > 0
+        ? static_cast<std::size_t>(config_.thread_count) : std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Parsing archived pages on " << threads << " threads" << std::endl;
+    auto process_batch = [&]() {
+        std::atomic<std::size_t> next{ 0 };
+        auto work = [&]() {
+            for (std::size_t i = next++; i < batch.size(); i = next++) {
+                process_page(batch[i]);
             }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < std::min(threads, batch.size()); ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
         }
+        batch.clear();
+    };
+#endif
 
+    for (const std::string& file : files) {
         try {
-            index_page(url, content);
+            WarcReader reader(file);
+            WarcRecord record;
+            while (reader.next(record)) {
+                records++;
+                if (record.type != "response") {
+                    continue;
+                }
+                // Повторные снимки одного URL индексируются один раз
+                std::string url;
+                if (!normalize_url(record.target_uri, url) || !visited_.insert(url)) {
+                    skipped++;
+                    continue;
+                }
+                FetchResult result;
+                std::string reason;
+                try {
+                    if (!decode_archived_response(record.block, max_body, result, reason)) {
+                        skipped++;
+                        continue;
+                    }
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Skipping archived " << url << ": " << e.what() << std::endl;
+                    skipped++;
+                    continue;
+                }
+                pages_fetched_++;
+                bytes_fetched_ += result.body.size();
+                batch.push_back(FetchedPage{ std::move(url), 0, std::move(result.body),
+                    std::move(result.etag), std::move(result.last_modified), std::move(result.content_type) });
+                if (batch.size() >= batch_size) {
+                    process_batch();
+                }
+            }
+            archive_bytes += reader.size();
         }
         catch (const std::exception& e) {
-            std::cerr << "Exception while indexing page: " << e.what() << std::endl;
+            std::cerr << "Error reading WARC file " << file << ": " << e.what() << std::endl;
         }
     }
+    process_batch();
+
+    shutdown();
+    index_writer_.flush();
+
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    run_seconds_ = seconds;
+    std::cout << "Ingested " << pages_fetched_ << " pages (" << bytes_fetched_ << " bytes) from " << records
+        << " WARC records (" << skipped << " skipped), " << archive_bytes / (1024 * 1024) << " MiB of archives in "
+        << seconds << " s: " << (seconds > 0 ? pages_fetched_ / seconds : 0.0) << " pages/s, "
+        << (seconds > 0 ? archive_bytes / seconds / (1024 * 1024) : 0.0) << " MiB/s, "
+        << links_found_ << " links found" << std::endl;
+    report_totals();
 }
 
-std::string Spider::fetch_page(const std::string& url) {
-    try {
-        net::io_context ioc;
-        ssl::context ctx(ssl::context::tlsv12_client);  //  TLS
-        ctx.set_default_verify_paths();
-
-        auto const scheme_end = url.find("://");
-        if (scheme_end == std::string::npos) {
-            throw std::invalid_argument("Invalid URL: missing scheme");
-        }
-
-        auto const scheme = url.substr(0, scheme_end);
-        auto const host_start = scheme_end + 3;
-        auto const host_end = url.find('/', host_start);
-        std::string host, target;
-        if (host_end == std::string::npos) {
-            host = url.substr(host_start);
-            target = "/";
-        }
-        else {
-            host = url.substr(host_start, host_end - host_start);
-            target = url.substr(host_end);
-        }
+// Итоги, общие для обхода и загрузки из архивов
+void Spider::report_totals() {
+    std::cout << "Charsets:";
+    for (std::size_t i = 1; i < kCharsetCount; ++i) {
+        std::cout << " " << charset_name(static_cast<Charset>(i)) << " " << charset_pages_[i];
+    }
+    std::cout << " pages, " << transcoded_ << " transcoded or repaired" << std::endl;
+    std::cout << "Visited set: " << visited_.size() << " URLs, " << visited_.memory_bytes() / 1024 << " KiB" << std::endl;
+    auto const index = index_writer_.stats();
+    std::cout << "Index writer: " << index.pages << " pages, " << index.postings << " postings in "
+        << index.batches << " batches (" << index.failed_batches << " failed, " << index.failed_pages << " pages lost), "
+        << index.aliases << " aliases, "
+        << index.unchanged << " validator updates" << std::endl;
+    auto const store = document_store_.stats();
+    std::cout << "Document store (" << document_store_.mode_name() << "): " << store.input_bytes / 1024 << " KiB fetched, "
+        << store.stored_bytes / 1024 << " KiB stored, ratio "
+        << (store.stored_bytes ? static_cast<double>(store.input_bytes) / store.stored_bytes : 0.0);
+    if (store.compress_seconds > 0) {
+        std::cout << ", compression " << store.input_bytes / store.compress_seconds / (1024 * 1024) << " MiB/s";
+    }
+    std::cout << ", index writes " << (index.write_seconds > 0 ? index.stored_bytes / index.write_seconds / (1024 * 1024) : 0.0)
+        << " MiB/s of content" << std::endl;
+    auto const duplicates = duplicates_.stats();
+    std::cout << "Duplicates: " << duplicates.exact << " exact, " << duplicates.near << " near among "
+        << duplicates.documents + duplicates.exact + duplicates.near << " pages" << std::endl;
+    auto const terms = db_.terms().stats();
+    std::size_t const term_lookups = terms.hits + terms.misses;
+    std::cout << "Term dictionary: " << terms.terms << " words, " << terms.bytes / 1024 << " KiB, hit rate "
+        << (term_lookups ? 100.0 * terms.hits / term_lookups : 0.0) << "%, " << terms.rejected
+        << " not cached over the limit" << std::endl;
+    auto const db_pool = db_.pool().stats();
+    std::cout << "Database pool: " << db_pool.acquired << " checkouts, " << db_pool.waits << " waits, "
+        << db_pool.reconnects << " reconnects" << std::endl;
+    std::cout << "Spider finished." << std::endl;
+}
 
-        tcp::resolver resolver(ioc);
-        auto const results = resolver.resolve(host, scheme);
+void Spider::enqueue_url(std::string url, int depth) {
+    pending_++;
+    frontier_.push(CrawlTask{ std::move(url), depth });
+    work_signal_.notify();
+}
 
-        if (scheme == "https") {
-            ssl::stream<tcp::socket> stream(ioc, ctx);
-            if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-                boost::system::error_code ec{ static_cast<int>(::ERR_get_error()), net::error::get_ssl_category() };
-                throw boost::system::system_error{ ec };
+// Инкрементальный обход: все сохраненные страницы ставятся в границу на своей
+// глубине. У неизмененных страниц ссылки не разбираются, поэтому их цели
+// должны попасть в обход отсюда, а не со страниц, которые на них ссылаются.
+void Spider::seed_from_crawl_state() {
+    try {
+        auto const started = std::chrono::steady_clock::now();
+        // Страницы без сохраненной глубины перезагружаются, но их ссылки не
+        // разбираются: с глубиной 0 обход разросся бы дальше исходного
+        crawl_state_.load(*db_.connection(), config_.recursion_depth);
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        std::vector<CrawlTask> tasks;
+        crawl_state_.for_each([&](const std::string& url, const CrawlState::Page& page) {
+            if (page.depth <= config_.recursion_depth && visited_.insert(url)) {
+                tasks.push_back(CrawlTask{ url, page.depth });
             }
+            });
+        std::cout << "Crawl state: " << crawl_state_.size() << " pages loaded in " << seconds << " s, "
+            << tasks.size() << " queued for recrawl" << std::endl;
+        pending_ += tasks.size();
+        frontier_.push(std::move(tasks));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception while loading crawl state: " << e.what() << std::endl;
+    }
+}
 
-            //  
-            net::connect(stream.next_layer(), results.begin(), results.end());
-            stream.handshake(ssl::stream_base::client);
+// Загрузчики приостанавливаются, взятые задачи дорабатываются до записи в базу,
+// и только тогда сохраняется граница: все, чего в ней нет, уже в базе
+void Spider::checkpoint() {
+    auto const started = std::chrono::steady_clock::now();
+    paused_ = true;
+    while (active_ > 0 || index_pending_ > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    try {
+        index_writer_.flush();
+        frontier_.checkpoint(visited_);
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        std::cout << "Checkpoint: " << frontier_.size() << " URLs in the frontier (" << frontier_.spilled()
+            << " on disk), " << visited_.size() << " visited, " << seconds << " s" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception while writing checkpoint: " << e.what() << std::endl;
+    }
+    paused_ = false;
+    work_signal_.notify();
+}
 
-            http::request<http::string_body> req{ http::verb::get, target, 11 };
-            req.set(http::field::host, host);
-            req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+void Spider::finish_task() {
+    active_--;
+    if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done_cv_.notify_all();
+    }
+}
 
-            http::write(stream, req);
+net::awaitable<void> Spider::fetch_loop(std::size_t worker) {
+    auto idle_timer = std::make_shared<net::steady_timer>(co_await net::this_coro::executor);
+
+    while (!stop_) {
+        // Поколение берется до pop: push между ними не будет пропущен
+        std::uint64_t const seen = work_signal_.generation();
+        // Счетчик увеличивается до проверки паузы, чтобы контрольная точка
+        // не пропустила задачу, взятую в этот момент
+        active_++;
+        std::optional<CrawlTask> task;
+        if (!paused_) {
+            task = frontier_.pop(worker);
+        }
+        if (!task) {
+            active_--;
+            // Очередь пуста, но страницы еще обрабатываются и могут дать новые ссылки:
+            // загрузчик спит до push. Если URL есть, но их хосты выжидают задержку
+            // вежливости, push не придет, и граница проверяется по таймеру
+            auto const timeout = frontier_.size() > 0 ? std::chrono::milliseconds(20) : std::chrono::milliseconds(1000);
+            co_await work_signal_.wait(idle_timer, seen, timeout);
+            continue;
+        }
 
-            boost::beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
+        auto [url, depth] = std::move(*task);
+        std::cout << "Crawling URL: " << url << " at depth: " << depth << std::endl;
 
-            http::read(stream, buffer, res);
+        if (depth > config_.recursion_depth) {
+            finish_task();
+            continue;
+        }
 
-            if (res.result() == http::status::moved_permanently || res.result() == http::status::found) {
-                auto location = res[http::field::location];
-                if (!location.empty()) {
-                    return fetch_page(std::string(location));
-                }
-                else {
-                    std::cerr << "Redirected without a new location" << std::endl;
-                    return "";
-                }
-            }
+        // Для сохраненной ранее страницы запрос условный
+        std::string_view etag, last_modified;
+        if (const CrawlState::Page* known = crawl_state_.find(url)) {
+            etag = known->etag;
+            last_modified = known->last_modified;
+        }
+        auto const fetch_started = std::chrono::steady_clock::now();
+        FetchResult result = co_await http_.fetch(url, etag, last_modified);
+        fetch_latency_.record(std::chrono::steady_clock::now() - fetch_started);
+        if (result.not_modified) {
+            not_modified_++;
+            finish_task();
+            continue;
+        }
+        if (result.body.empty()) {
+            std::cerr << "Fetched content is empty for URL: " << url << std::endl;
+            finish_task();
+            continue;
+        }
 
-            if (res.result() != http::status::ok) {
-                std::cerr << "HTTP request failed: " << res.result_int() << " " << res.reason() << std::endl;
-                return "";
+        pages_fetched_++;
+        bytes_fetched_ += result.body.size();
+
+        // Очередь разбора полна: ждем, не занимая поток io_context
+        FetchedPage page{ std::move(url), depth, std::move(result.body), std::move(result.etag), std::move(result.last_modified),
+            std::move(result.content_type) };
+        bool queued = parse_queue_.try_push(page);
+        while (!queued && !stop_) {
+            fetch_stalls_++;
+            std::uint64_t const seen = parse_space_.generation();
+            queued = parse_queue_.try_push(page);
+            if (!queued) {
+                co_await parse_space_.wait(idle_timer, seen, std::chrono::milliseconds(1000));
+                queued = parse_queue_.try_push(page);
             }
-
-            std::string page_content = boost::beast::buffers_to_string(res.body().data());
-            return page_content;
         }
-        else if (scheme == "http") {
-            tcp::socket socket(ioc);
+        if (!queued) {
+            finish_task();
+        }
+    }
+}
 
-            //  
-            net::connect(socket, results.begin(), results.end());
+void Spider::parse_worker() {
+    FetchedPage page;
+    while (parse_queue_.pop_wait(page)) {
+        parse_space_.notify();
+        process_page(page);
+        finish_task();
+    }
+}
 
-            http::request<http::string_body> req{ http::verb::get, target, 11 };
-            req.set(http::field::host, host);
-            req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+void Spider::index_worker() {
+    IndexedPage page;
+    while (index_queue_.pop_wait(page)) {
+        index_writer_.add(std::move(page));
+        pages_indexed_++;
+        index_pending_--;
+    }
+}
 
-            http::write(socket, req);
+void Spider::report_pipeline() {
+    std::cout << "Pipeline: frontier " << frontier_.size() << " (" << frontier_.spilled() << " on disk)"
+        << ", parse queue " << parse_queue_.size() << "/" << parse_queue_.capacity()
+        << ", index queue " << index_queue_.size() << "/" << index_queue_.capacity()
+        << ", fetched " << pages_fetched_ << ", indexed " << pages_indexed_
+        << ", fetch stalls " << fetch_stalls_ << std::endl;
+}
 
-            boost::beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
+void Spider::process_page(const FetchedPage& page) {
+    std::cout << "Processing content for URL: " << page.url << std::endl;
+
+    // Сервер отдал страницу целиком, но она не изменилась: не разбираем и не
+    // переиндексируем, а только запоминаем новые валидаторы, если они есть
+    std::uint64_t const content_hash = hash64(page.content);
+    if (const CrawlState::Page* known = crawl_state_.find(page.url); known && known->content_hash == content_hash) {
+        unchanged_++;
+        if (known->etag != page.etag || known->last_modified != page.last_modified) {
+            IndexedPage indexed;
+            indexed.url = page.url;
+            indexed.unchanged = true;
+            indexed.etag = page.etag;
+            indexed.last_modified = page.last_modified;
+            index_pending_++;
+            index_queue_.push_wait(indexed);
+        }
+        return;
+    }
+    // Закомментируем вывод большого объёма данных
+    // std::cout << "Content snippet: " << page.content.substr(0, 1000) << "..." << std::endl;
+
+    // Страница приводится к UTF-8 до разбора, чтобы и ссылки, и текст были в одной кодировке.
+    // Корректный UTF-8 (большинство страниц) не копируется.
+    thread_local std::string decoded;
+    Charset charset = Charset::Unknown;
+    std::string_view const html = decode_html(page.content, page.content_type, default_charset_, decoded, charset);
+    charset_pages_[static_cast<std::size_t>(charset)]++;
+    if (html.data() == decoded.data()) {
+        transcoded_++;
+    }
 
-            http::read(socket, buffer, res);
+    // Один проход по странице дает и ссылки, и текст для индексации
+    ParsedHtml parsed;
+    scan_html(html, parsed);
 
-            if (res.result() == http::status::moved_permanently || res.result() == http::status::found) {
-                auto location = res[http::field::location];
-                if (!location.empty()) {
-                    return fetch_page(std::string(location));
-                }
-                else {
-                    std::cerr << "Redirected without a new location" << std::endl;
-                    return "";
-                }
-            }
+    if (offline_) {
+        // Ссылки разбираются, как при обходе, но в границу не попадают: страницы берутся из архива
+        links_found_ += extract_links(parsed, page.url).size();
+    }
+    else if (page.depth < config_.recursion_depth) {
+        std::vector<std::string> links;
+        try {
+            // Передаем текущий URL как базовый
+            links = extract_links(parsed, page.url);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Exception while extracting links: " << e.what() << std::endl;
+            return;
+        }
 
-            if (res.result() != http::status::ok) {
-                std::cerr << "HTTP request failed: " << res.result_int() << " " << res.reason() << std::endl;
-                return "";
+        std::vector<CrawlTask> tasks;
+        tasks.reserve(links.size());
+        for (std::string& link : links) {
+            // Отметка при постановке в очередь: каждый URL попадает в границу один раз
+            if (visited_.insert(link)) {
+                tasks.push_back(CrawlTask{ std::move(link), page.depth + 1 });
             }
-
-            std::string page_content = boost::beast::buffers_to_string(res.body().data());
-            return page_content;
         }
-        else {
-            std::cerr << "Unsupported URL scheme: " << scheme << std::endl;
-            return "";
+        if (!tasks.empty()) {
+            pending_ += tasks.size();
+            frontier_.push(std::move(tasks));
+            work_signal_.notify();
         }
     }
-    catch (std::exception& e) {
-        std::cerr << "Error fetching page: " << e.what() << std::endl;
-        return "";
+
+    try {
+        IndexedPage indexed;
+        if (index_page(page.url, html, parsed.text, indexed)) {
+            indexed.etag = page.etag;
+            indexed.last_modified = page.last_modified;
+            indexed.content_hash = content_hash;
+            indexed.depth = page.depth;
+            // Блокируется, если стадия записи отстает
+            index_pending_++;
+            index_queue_.push_wait(indexed);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception while indexing page: " << e.what() << std::endl;
     }
 }
 
-
-std::vector<std::string> Spider::extract_links(const std::string& content, const std::string& base_url) {
+// Ссылки разрешаются относительно канонического URL страницы и сами приводятся
+// к канонической форме, поэтому варианты записи одного адреса не попадают в границу
+std::vector<std::string> Spider::extract_links(const ParsedHtml& parsed, const std::string& base_url) {
     std::vector<std::string> links;
     try {
-        std::regex link_regex(R"(<a\s+(?:[^>]*?\s+)?href=["']([^"']*)["'])");
-        std::smatch match;
-
-        std::string::const_iterator search_start(content.cbegin());
-        while (std::regex_search(search_start, content.cend(), match, link_regex)) {
-            std::string link = match[1].str();
-            if (link.empty() || link.find("javascript:") == 0) {
+        UrlParts base;
+        if (!parse_url(base_url, base)) {
+            return links;
+        }
+        links.reserve(parsed.links.size());
+        thread_local std::string absolute_link;
+        for (const std::string& link : parsed.links) {
+            // mailto:, javascript: и некорректные ссылки отбрасываются
+            if (!resolve_url(base, link, absolute_link)) {
                 // std::cerr << "Skipping invalid link: " << link << std::endl;
-                search_start = match.suffix().first;
                 continue;
             }
-            std::string absolute_link = resolve_url(base_url, link);
             // std::cout << "Found link: " << link << " Resolved to: " << absolute_link << std::endl;
             links.push_back(absolute_link);
-            search_start = match.suffix().first;
         }
 
         // std::cout << "Total links found: " << links.size() << std::endl;
@@ -304,155 +622,46 @@ std::vector<std::string> Spider::extract_links(const std::string& content, const
     return links;
 }
 
-void Spider::index_page(const std::string& url, const std::string& content) {
+bool Spider::index_page(const std::string& url, std::string_view content, const std::string& text_content, IndexedPage& page) {
     try {
         if (content.empty()) {
             std::cerr << "Empty content for URL: " << url << std::endl;
-            return;
+            return false;
         }
 
-        // Initialize locale
-        boost::locale::generator gen;
-        std::locale loc = gen("");
-        std::locale::global(loc);
-        std::cout.imbue(loc);
-
-        // Convert string to UTF-8
-        std::string utf8_content = boost::locale::conv::to_utf<char>(content, "UTF-8");
-        std::string text = boost::locale::to_lower(utf8_content);
-
-        // Remove HTML tags and special characters
-        text = std::regex_replace(text, std::regex("<[^>]*>"), " ");
-        text = std::regex_replace(text, std::regex("[^\\w\\s]"), " ");
-
-        std::map<std::string, int> word_freq;
-        std::istringstream iss(text);
-        std::string word;
-        while (iss >> word) {
-            if (word.length() >= 3 && word.length() <= 32) {
-                word_freq[word]++;
+        // Текст уже в UTF-8: страница перекодирована в process_page
+        const std::string& utf8_text = text_content;
+
+        // Текст копируется в арену потока и приводится к нижнему регистру на месте;
+        // таблица терминов ссылается на него, поэтому на слово нет аллокаций
+        thread_local Arena arena;
+        arena.reset();
+        char* text = arena.copy(utf8_text);
+        TermTable word_freq(arena);
+        count_terms(text, utf8_text.size(), word_freq);
+
+        page.url = url;
+        if (word_freq.size() > 0) {
+            // Текст уже в нижнем регистре, поэтому отпечаток не зависит от регистра
+            std::uint64_t const exact = hash64(std::string_view(text, utf8_text.size()));
+            auto original = duplicates_.check(url, exact, simhash(word_freq), word_freq.size());
+            if (original) {
+                page.alias_of = std::move(*original);
+                return true;
             }
         }
 
-        pqxx::work txn(db_.conn());
-
-        try {
-            db_.save_document(url, content, txn);
-
-            pqxx::result r = txn.exec_params("SELECT id FROM search_engine.documents WHERE url = $1", url);
-            if (r.empty()) {
-                std::cerr << "Document not found for URL: " << url << std::endl;
-                txn.abort();
-                return;
-            }
+        document_store_.encode(content, utf8_text, page.content, page.content_zstd);
+        page.counts.reserve(word_freq.size());
+        word_freq.for_each_entry([&](const TermTable::Entry& entry) {
+            page.add_word(entry.term(), entry.count, entry.position_deltas());
+            page.length += entry.count;
+        });
 
-            int document_id = r[0][0].as<int>();
-
-            for (const auto& [word, freq] : word_freq) {
-                db_.save_word_frequency(document_id, word, freq, txn);
-            }
-
-            txn.commit();
-            // std::cout << "Transaction committed for URL: " << url << std::endl;
-        }
-        catch (const std::exception& e) {
-            txn.abort();
-            std::cerr << "Transaction error: " << e.what() << std::endl;
-        }
-    }
-    catch (const pqxx::sql_error& e) {
-        std::cerr << "SQL error: " << e.what() << std::endl;
-        std::cerr << "Query was: " << e.query() << std::endl;
+        return true;
     }
     catch (const std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
     }
-}
-
-std::string Spider::ensure_scheme(const std::string& url) {
-    if (url.find("http://") == 0 || url.find("https://") == 0) {
-        return url;
-    }
-    return "http://" + url;
-}
-
-//   parse_url
-Spider::UrlComponents Spider::parse_url(const std::string& url) {
-    std::regex url_regex(R"(^((https?)://)?([^/]+)(/.*)?)");
-    std::smatch url_match_result;
-
-    if (std::regex_match(url, url_match_result, url_regex)) {
-        UrlComponents result;
-        result.scheme = url_match_result[2].str().empty() ? "http" : url_match_result[2].str();
-        result.host = url_match_result[3].str();
-        result.path = url_match_result[4].str();
-        if (result.path.empty()) {
-            result.path = "/";
-        }
-        return result;
-    }
-    else {
-        throw std::invalid_argument("Invalid URL: " + url);
-    }
-}
-
-//   resolve_url
-std::string Spider::resolve_url(const std::string& base_url, const std::string& link) {
-    //     ,  
-    if (link.find("http://") == 0 || link.find("https://") == 0) {
-        return link;
-    }
-    else if (link.find("//") == 0) {
-        // - URL
-        UrlComponents base = parse_url(base_url);
-        return base.scheme + ":" + link;
-    }
-    else if (link.find("/") == 0) {
-        //    
-        UrlComponents base = parse_url(base_url);
-        return base.scheme + "://" + base.host + link;
-    }
-    else {
-        //  
-        UrlComponents base = parse_url(base_url);
-        //      ,   
-        std::string base_path = base.path;
-        size_t pos = base_path.rfind('/');
-        if (pos != std::string::npos) {
-            base_path = base_path.substr(0, pos + 1);
-        }
-        else {
-            base_path = "/";
-        }
-        std::string combined_path = base_path + link;
-
-        //  ,  "../"  "./"
-        std::vector<std::string> segments;
-        std::istringstream path_stream(combined_path);
-        std::string segment;
-        while (std::getline(path_stream, segment, '/')) {
-            if (segment == "..") {
-                if (!segments.empty()) {
-                    segments.pop_back();
-                }
-            }
-            else if (segment != "." && !segment.empty()) {
-                segments.push_back(segment);
-            }
-        }
-
-        //   
-        std::string normalized_path = "/";
-        for (size_t i = 0; i < segments.size(); ++i) {
-            normalized_path += segments[i];
-            if (i != segments.size() - 1) {
-                normalized_path += "/";
-            }
-        }
-        if (combined_path.back() == '/') {
-            normalized_path += "/";
-        }
-
-        return base.scheme + "://" + base.host + normalized_path;
-    }
+    return false;
 }
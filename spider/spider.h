@@ -2,56 +2,128 @@
 #define SPIDER_H
 
 #include <string>
-#include <set>
-#include <queue>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <array>
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/executor_work_guard.hpp>
 #include "../config/config.h"
+#include "../database/crawl_state.h"
 #include "../database/database.h"
+#include "../database/index_writer.h"
+#include "charset.h"
+#include "duplicate_index.h"
+#include "frontier.h"
+#include "html_scanner.h"
+#include "latency_histogram.h"
+#include "mpmc_queue.h"
+#include "http_client.h"
+#include "visited_set.h"
+#include "wake_signal.h"
 
 class Spider {
 public:
+    // Итоги последнего запуска (для бенчмарка)
+    struct Stats {
+        double seconds = 0;
+        std::size_t pages_fetched = 0;
+        std::size_t bytes_fetched = 0;
+        std::size_t pages_indexed = 0;
+        double fetch_p50_ms = 0;
+        double fetch_p99_ms = 0;
+        IndexWriter::Stats index;
+    };
+
     Spider(const Config& config, Database& db);
     ~Spider();
-    void start();
+    // resume - продолжить с последней контрольной точки в spider.frontier_dir
+    void start(bool resume = false);
+    // Индексирует страницы из WARC-файлов вместо обхода сети
+    void ingest(const std::vector<std::string>& files);
+
+    Stats stats() const;
 
 private:
-    std::string fetch_page(const std::string& url);
-    std::vector<std::string> extract_links(const std::string& content, const std::string& base_url);
-    void index_page(const std::string& url, const std::string& content);
-    void worker_thread(); //    
-    std::string ensure_scheme(const std::string& url);
-
-    //         URL
-    struct UrlComponents {
-        std::string scheme;
-        std::string host;
-        std::string path;
+    // Загруженная страница, ожидающая разбора и индексации
+    struct FetchedPage {
+        std::string url;
+        int depth = 0;
+        std::string content;
+        std::string etag;
+        std::string last_modified;
+        std::string content_type;
     };
 
-    UrlComponents parse_url(const std::string& url);
-    std::string resolve_url(const std::string& base_url, const std::string& link);
+    // Стадии конвейера: загрузка (корутины) -> разбор (пул по числу ядер) -> запись в базу
+    boost::asio::awaitable<void> fetch_loop(std::size_t worker); // Корутина загрузки страниц
+    void parse_worker();
+    void index_worker();
+
+    void enqueue_url(std::string url, int depth);
+    void seed_from_crawl_state();
+    void start_index_threads();
+    void report_totals();
+    void checkpoint();
+    void finish_task();
+    void process_page(const FetchedPage& page);
+    void shutdown();
+    void report_pipeline();
+    std::vector<std::string> extract_links(const ParsedHtml& parsed, const std::string& base_url);
+    bool index_page(const std::string& url, std::string_view content, const std::string& text, IndexedPage& page);
 
     Config config_;
     Database& db_;
-    std::set<std::string> visited_;
-    std::queue<std::pair<std::string, int>> urls_;
-    std::mutex queue_mutex_;
-    std::mutex visited_mutex_;
-    std::condition_variable cv_;
-    bool stop_ = false;
+    IndexWriter index_writer_;
+    VisitedSet visited_;
+    Frontier frontier_;
+    DuplicateIndex duplicates_;
+    DocumentStore document_store_;
+    CrawlState crawl_state_; // Ранее сохраненные страницы (инкрементальный режим), только чтение
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    std::atomic<std::size_t> pending_{ 0 }; // URL в очереди, в загрузке или в обработке
+    std::atomic<bool> stop_{ false };
+    Charset default_charset_; // Для страниц без объявленной кодировки и не в UTF-8
+    bool offline_ = false; // Загрузка из WARC: ссылки не ставятся в очередь
+    // На время контрольной точки загрузчики не берут новые задачи
+    std::atomic<bool> paused_{ false };
+    std::atomic<std::size_t> active_{ 0 };        // Взятые из границы и еще не обработанные задачи
+    std::atomic<std::size_t> index_pending_{ 0 }; // Страницы в очереди записи и в IndexWriter::add
+
+    // Ограниченные очереди между стадиями: когда база не успевает, заполняется
+    // index_queue_, за ней parse_queue_, и загрузчики приостанавливаются
+    MpmcQueue<FetchedPage> parse_queue_;
+    MpmcQueue<IndexedPage> index_queue_;
+    // Простаивающие загрузчики спят на сигналах, а не опрашивают по таймеру
+    WakeSignal work_signal_;  // Новые URL в границе, конец контрольной точки
+    WakeSignal parse_space_;  // Место в очереди разбора
 
     boost::asio::io_context ioc_;
     boost::asio::ssl::context ssl_ctx_;
     boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_;
-    std::vector<std::thread> thread_pool_; //  
-    std::atomic<int> active_threads_{ 0 };
+    HttpClient http_;
+    std::vector<std::thread> io_threads_;  // Потоки io_context
+    std::vector<std::thread> parse_threads_;
+    std::vector<std::thread> index_threads_;
 
+    std::atomic<std::size_t> pages_fetched_{ 0 };
+    std::atomic<std::size_t> bytes_fetched_{ 0 };
+    std::atomic<std::size_t> pages_indexed_{ 0 };
+    double run_seconds_ = 0;
+    LatencyHistogram fetch_latency_; // Загрузка страницы вместе с редиректами
+    std::atomic<std::size_t> fetch_stalls_{ 0 }; // Сколько раз загрузчик ждал места в очереди разбора
+    std::atomic<std::size_t> not_modified_{ 0 }; // Ответы 304
+    std::atomic<std::size_t> unchanged_{ 0 };    // Загружены заново, но отпечаток совпал
+    std::atomic<std::size_t> links_found_{ 0 };  // Ссылки в страницах из WARC (в очередь не ставятся)
+    std::array<std::atomic<std::size_t>, kCharsetCount> charset_pages_{}; // Страницы по исходной кодировке
+    std::atomic<std::size_t> transcoded_{ 0 };   // Перекодированы или исправлены, а не переданы как есть
 };
 
 #endif // SPIDER_H
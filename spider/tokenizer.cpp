@@ -0,0 +1,397 @@
+#include "tokenizer.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "hash.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TOKENIZER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2 1
+#endif
+
+namespace {
+
+constexpr std::size_t kMinWord = 3;
+constexpr std::size_t kMaxWord = 32;
+
+bool is_word_ascii(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Буквы и цифры вне ASCII; знаки препинания и символы - разделители слов
+bool is_word_codepoint(std::uint32_t cp) {
+    if (cp < 0xC0) {
+        return cp == 0xAA || cp == 0xB5 || cp == 0xBA;
+    }
+    if (cp == 0xD7 || cp == 0xF7 || cp == 0xFFFD) {
+        return false;
+    }
+    if ((cp >= 0x2000 && cp <= 0x2BFF) ||   // Пунктуация, валюты, стрелки, символы
+        (cp >= 0x3000 && cp <= 0x303F) ||   // Пунктуация CJK
+        (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF00 && cp <= 0xFF0F)) {
+        return false;
+    }
+    return true;
+}
+
+// Нижний регистр для латиницы, греческого и кириллицы. Все эти пары
+// кодируются в UTF-8 одинаковым числом байт, поэтому замена идет на месте.
+std::uint32_t to_lower_codepoint(std::uint32_t cp) {
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) {
+        return cp + 0x20;
+    }
+    if (cp >= 0x100 && cp <= 0x17F && cp != 0x130) {
+        bool const even_upper = cp <= 0x137 || (cp >= 0x14A && cp <= 0x177);
+        bool const odd_upper = (cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E);
+        if ((even_upper && cp % 2 == 0) || (odd_upper && cp % 2 == 1)) {
+            return cp + 1;
+        }
+        return cp;
+    }
+    if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) {
+        return cp + 0x20;
+    }
+    if (cp >= 0x410 && cp <= 0x42F) {
+        return cp + 0x20;
+    }
+    if (cp >= 0x400 && cp <= 0x40F) {
+        return cp + 0x50;
+    }
+    if (((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF)) && cp % 2 == 0) {
+        return cp + 1;
+    }
+    return cp;
+}
+
+// Декодирует символ UTF-8; для некорректной последовательности возвращает U+FFFD длиной 1
+std::uint32_t decode_utf8(const unsigned char* p, std::size_t available, std::size_t& length) {
+    unsigned char const c = p[0];
+    std::uint32_t cp;
+    std::size_t n;
+    if (c >= 0xC2 && c <= 0xDF) {
+        cp = c & 0x1F;
+        n = 2;
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        cp = c & 0x0F;
+        n = 3;
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        cp = c & 0x07;
+        n = 4;
+    }
+    else {
+        length = 1;
+        return 0xFFFD;
+    }
+
+    if (n > available) {
+        length = 1;
+        return 0xFFFD;
+    }
+    for (std::size_t i = 1; i < n; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            length = 1;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    length = n;
+    return cp;
+}
+
+// Sink - TermTable или любой другой приемник с методами add(std::string_view)
+// и skip() - для слов, выброшенных по длине
+template <class Sink>
+class WordScanner {
+public:
+    WordScanner(char* text, Sink& sink) : text_(text), sink_(sink) {}
+
+    void step(bool word, std::size_t pos) {
+        if (word) {
+            if (!in_word_) {
+                start_ = pos;
+                in_word_ = true;
+            }
+        }
+        else if (in_word_) {
+            emit(pos);
+        }
+    }
+
+    // Обрабатывает битовую маску символов слова для блока из width байт
+    void mask(std::uint32_t word, unsigned width, std::size_t base) {
+        std::uint32_t const full = width == 32 ? ~0u : (1u << width) - 1;
+        unsigned pos = 0;
+        while (pos < width) {
+            std::uint32_t const rest = full & (~0u << pos);
+            if (in_word_) {
+                std::uint32_t const breaks = ~word & rest;
+                if (!breaks) {
+                    return;
+                }
+                pos = static_cast<unsigned>(std::countr_zero(breaks));
+                emit(base + pos);
+            }
+            else {
+                std::uint32_t const starts = word & rest;
+                if (!starts) {
+                    return;
+                }
+                pos = static_cast<unsigned>(std::countr_zero(starts));
+                start_ = base + pos;
+                in_word_ = true;
+            }
+        }
+    }
+
+    // Один символ: байт ASCII или последовательность UTF-8. Возвращает его длину.
+    std::size_t scalar(std::size_t pos, std::size_t size) {
+        unsigned char* p = reinterpret_cast<unsigned char*>(text_ + pos);
+        if (*p < 0x80) {
+            if (*p >= 'A' && *p <= 'Z') {
+                *p |= 0x20;
+            }
+            step(is_word_ascii(*p), pos);
+            return 1;
+        }
+
+        std::size_t length;
+        std::uint32_t const cp = decode_utf8(p, size - pos, length);
+        std::uint32_t const lower = to_lower_codepoint(cp);
+        if (lower != cp) {
+            p[0] = static_cast<unsigned char>(0xC0 | (lower >> 6));
+            p[1] = static_cast<unsigned char>(0x80 | (lower & 0x3F));
+        }
+        step(is_word_codepoint(cp), pos);
+        return length;
+    }
+
+    void finish(std::size_t size) {
+        if (in_word_) {
+            emit(size);
+        }
+    }
+
+private:
+    void emit(std::size_t end) {
+        std::size_t const length = end - start_;
+        if (length >= kMinWord && length <= kMaxWord) {
+            sink_.add(std::string_view(text_ + start_, length));
+        }
+        else {
+            sink_.skip();
+        }
+        in_word_ = false;
+    }
+
+    char* text_;
+    Sink& sink_;
+    std::size_t start_ = 0;
+    bool in_word_ = false;
+};
+
+#if defined(TOKENIZER_AVX2)
+
+constexpr std::size_t kBlock = 32;
+
+// Приводит блок ASCII к нижнему регистру и возвращает маску символов слова.
+// Возвращает false, если в блоке есть байты вне ASCII.
+bool fold_block(char* p, std::uint32_t& word) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    if (_mm256_movemask_epi8(v) != 0) {
+        return false;
+    }
+    __m256i const upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+    v = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+
+    __m256i const lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+    __m256i const digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+    __m256i const underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    word = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(lower, digit), underscore)));
+    return true;
+}
+
+#elif defined(TOKENIZER_SSE2)
+
+constexpr std::size_t kBlock = 16;
+
+bool fold_block(char* p, std::uint32_t& word) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (_mm_movemask_epi8(v) != 0) {
+        return false;
+    }
+    __m128i const upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+
+    __m128i const lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+    __m128i const digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i const underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    word = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(lower, digit), underscore)));
+    return true;
+}
+
+#else
+
+constexpr std::size_t kBlock = 8;
+
+bool fold_block(char* p, std::uint32_t& word) {
+    std::uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    if (chunk & 0x8080808080808080ULL) {
+        return false;
+    }
+    word = 0;
+    for (unsigned i = 0; i < kBlock; ++i) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        if (c >= 'A' && c <= 'Z') {
+            c |= 0x20;
+            p[i] = static_cast<char>(c);
+        }
+        if (is_word_ascii(c)) {
+            word |= 1u << i;
+        }
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
+TermTable::TermTable(Arena& arena, std::size_t capacity)
+    : arena_(arena), slots_(arena.allocate_array<Entry>(std::bit_ceil(capacity))), capacity_(std::bit_ceil(capacity)) {
+}
+
+void TermTable::add(std::string_view term) {
+    if ((size_ + 1) * 2 > capacity_) {
+        grow();
+    }
+
+    std::uint32_t const hash = static_cast<std::uint32_t>(hash64(term));
+    std::uint32_t const position = position_++;
+    std::size_t const mask = capacity_ - 1;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Entry& slot = slots_[i];
+        if (!slot.data) {
+            slot.data = term.data();
+            slot.size = static_cast<std::uint32_t>(term.size());
+            slot.hash = hash;
+            slot.count = 1;
+            add_position(slot, position);
+            size_++;
+            return;
+        }
+        if (slot.hash == hash && slot.size == term.size() && std::memcmp(slot.data, term.data(), term.size()) == 0) {
+            slot.count++;
+            add_position(slot, position);
+            return;
+        }
+    }
+}
+
+// Первая позиция пишется как есть (last_position равна 0), следующие - разностью
+void TermTable::add_position(Entry& entry, std::uint32_t position) {
+    if (entry.positions_capacity - entry.positions_size < 5) {
+        // Старый буфер остается в арене: удвоение держит потери в пределах вдвое
+        std::uint32_t const capacity = std::max<std::uint32_t>(8, entry.positions_capacity * 2);
+        char* positions = static_cast<char*>(arena_.allocate(capacity, 1));
+        if (entry.positions_size > 0) {
+            std::memcpy(positions, entry.positions, entry.positions_size);
+        }
+        entry.positions = positions;
+        entry.positions_capacity = capacity;
+    }
+    std::uint32_t delta = position - entry.last_position;
+    while (delta >= 0x80) {
+        entry.positions[entry.positions_size++] = static_cast<char>(delta | 0x80);
+        delta >>= 7;
+    }
+    entry.positions[entry.positions_size++] = static_cast<char>(delta);
+    entry.last_position = position;
+}
+
+void TermTable::grow() {
+    Entry* old = slots_;
+    std::size_t const old_capacity = capacity_;
+    capacity_ *= 2;
+    slots_ = arena_.allocate_array<Entry>(capacity_);
+
+    std::size_t const mask = capacity_ - 1;
+    for (std::size_t i = 0; i < old_capacity; ++i) {
+        if (!old[i].data) {
+            continue;
+        }
+        std::size_t j = old[i].hash & mask;
+        while (slots_[j].data) {
+            j = (j + 1) & mask;
+        }
+        slots_[j] = old[i];
+    }
+}
+
+namespace {
+
+template <class Sink>
+void scan_words(char* text, std::size_t size, Sink& sink) {
+    WordScanner<Sink> scanner(text, sink);
+    std::size_t pos = 0;
+    while (pos < size) {
+        std::uint32_t word;
+        if (pos + kBlock <= size && fold_block(text + pos, word)) {
+            scanner.mask(word, static_cast<unsigned>(kBlock), pos);
+            pos += kBlock;
+            continue;
+        }
+
+        // Блок с многобайтовыми символами или хвост текста
+        std::size_t const limit = std::min(size, pos + kBlock);
+        while (pos < limit) {
+            pos += scanner.scalar(pos, size);
+        }
+    }
+    scanner.finish(size);
+}
+
+struct WordList {
+    std::vector<std::string_view>& words;
+    std::vector<std::uint32_t>* positions = nullptr;
+    std::uint32_t position = 0;
+
+    void add(std::string_view word) {
+        words.push_back(word);
+        if (positions) {
+            positions->push_back(position);
+        }
+        position++;
+    }
+    void skip() { position++; }
+};
+
+} // namespace
+
+void count_terms(char* text, std::size_t size, TermTable& terms) {
+    scan_words(text, size, terms);
+}
+
+void split_terms(char* text, std::size_t size, std::vector<std::string_view>& words) {
+    WordList list{ words };
+    scan_words(text, size, list);
+}
+
+void split_terms(char* text, std::size_t size, std::vector<std::string_view>& words, std::vector<std::uint32_t>& positions) {
+    WordList list{ words, &positions };
+    scan_words(text, size, list);
+}
@@ -0,0 +1,79 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+// Таблица частот терминов с открытой адресацией. Ключи - string_view
+// в буфер страницы, слоты выделяются из арены: на слово не бывает аллокаций.
+// Для каждого термина копятся и его позиции (номера слов на странице):
+// разности соседних позиций в varint, 7 бит на байт.
+class TermTable {
+public:
+    struct Entry {
+        const char* data = nullptr;
+        std::uint32_t size = 0;
+        std::uint32_t hash = 0;
+        int count = 0;
+        std::uint32_t last_position = 0;
+        char* positions = nullptr;
+        std::uint32_t positions_size = 0;
+        std::uint32_t positions_capacity = 0;
+
+        std::string_view term() const { return { data, size }; }
+        std::string_view position_deltas() const { return { positions, positions_size }; }
+    };
+
+    explicit TermTable(Arena& arena, std::size_t capacity = 1024);
+
+    void add(std::string_view term);
+    // Слово, не попавшее в индекс по длине: номер у него есть, как и у
+    // остальных, иначе фраза через него совпала бы с соседними словами
+    void skip() { position_++; }
+
+    std::size_t size() const { return size_; }
+
+    template <class F>
+    void for_each(F&& f) const {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (slots_[i].data) {
+                f(slots_[i].term(), slots_[i].count);
+            }
+        }
+    }
+
+    template <class F>
+    void for_each_entry(F&& f) const {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (slots_[i].data) {
+                f(slots_[i]);
+            }
+        }
+    }
+
+private:
+    void grow();
+    void add_position(Entry& entry, std::uint32_t position);
+
+    Arena& arena_;
+    Entry* slots_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    std::uint32_t position_ = 0; // Номер следующего слова страницы
+};
+
+// Приводит текст к нижнему регистру на месте и добавляет в таблицу слова
+// длиной от 3 до 32 байт. ASCII обрабатывается векторно (SSE2/AVX2),
+// многобайтовые символы UTF-8 - скалярно.
+void count_terms(char* text, std::size_t size, TermTable& terms);
+
+// То же разбиение на слова, но слова дописываются в words по порядку,
+// с повторами. Нужно там, где важны позиции: запросы и фразы.
+void split_terms(char* text, std::size_t size, std::vector<std::string_view>& words);
+// И номера этих слов в тексте с учетом выброшенных по длине, как в TermTable
+void split_terms(char* text, std::size_t size, std::vector<std::string_view>& words, std::vector<std::uint32_t>& positions);
+
+#endif // TOKENIZER_H
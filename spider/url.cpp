@@ -0,0 +1,342 @@
+#include "url.h"
+#include <algorithm>
+
+namespace {
+
+bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+char to_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (to_lower(a[i]) != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_http(std::string_view scheme) {
+    return iequals(scheme, "http") || iequals(scheme, "https");
+}
+
+// Незарезервированные символы RFC 3986: в %XX не кодируются
+bool is_unreserved(unsigned char c) {
+    return is_alpha(static_cast<char>(c)) || is_digit(static_cast<char>(c)) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+// Символы, которые в пути и запросе встречаются только закодированными
+bool needs_encoding(unsigned char c) {
+    return c <= 0x20 || c >= 0x7F || c == '"' || c == '<' || c == '>' || c == '\\' ||
+        c == '^' || c == '`' || c == '{' || c == '|' || c == '}';
+}
+
+void append_encoded(std::string& out, unsigned char c) {
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    out += '%';
+    out += kHex[c >> 4];
+    out += kHex[c & 15];
+}
+
+// Дописывает компонент с нормализованным percent-encoding
+void append_normalized(std::string& out, std::string_view part) {
+    for (std::size_t i = 0; i < part.size(); ++i) {
+        unsigned char const c = static_cast<unsigned char>(part[i]);
+        if (c == '%') {
+            int const high = i + 2 < part.size() ? hex_value(part[i + 1]) : -1;
+            int const low = high >= 0 ? hex_value(part[i + 2]) : -1;
+            if (low < 0) {
+                append_encoded(out, '%'); // Одиночный '%' - это символ, а не начало тройки
+                continue;
+            }
+            unsigned char const decoded = static_cast<unsigned char>(high * 16 + low);
+            if (is_unreserved(decoded)) {
+                out += static_cast<char>(decoded);
+            }
+            else {
+                append_encoded(out, decoded);
+            }
+            i += 2;
+        }
+        else if (needs_encoding(c)) {
+            append_encoded(out, c);
+        }
+        else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+// Отбрасывает последний сегмент пути в out, не заходя левее root
+void pop_segment(std::string& out, std::size_t root) {
+    std::size_t const slash = out.rfind('/');
+    out.resize(slash == std::string::npos || slash < root ? root : slash);
+}
+
+// remove_dot_segments из RFC 3986, 5.2.4: результат дописывается в out
+void remove_dot_segments(std::string_view in, std::string& out) {
+    std::size_t const root = out.size();
+    while (!in.empty()) {
+        if (in.starts_with("../")) {
+            in.remove_prefix(3);
+        }
+        else if (in.starts_with("./")) {
+            in.remove_prefix(2);
+        }
+        else if (in.starts_with("/./")) {
+            in.remove_prefix(2);
+        }
+        else if (in == "/.") {
+            in = "/";
+        }
+        else if (in.starts_with("/../")) {
+            in.remove_prefix(3);
+            pop_segment(out, root);
+        }
+        else if (in == "/..") {
+            in = "/";
+            pop_segment(out, root);
+        }
+        else if (in == "." || in == "..") {
+            in = {};
+        }
+        else {
+            std::size_t const next = in.find('/', 1);
+            std::string_view const segment = in.substr(0, next);
+            out.append(segment);
+            in.remove_prefix(segment.size());
+        }
+    }
+}
+
+// Собирает каноническую форму: схема и authority из authority, путь - prefix + path
+bool build(std::string_view scheme, const UrlParts& authority, std::string_view prefix, std::string_view path,
+    bool has_query, std::string_view query, std::string& out) {
+    if (authority.host.empty()) {
+        return false;
+    }
+
+    out.clear();
+    for (char c : scheme) {
+        out += to_lower(c);
+    }
+    out += "://";
+    if (!authority.userinfo.empty()) {
+        append_normalized(out, authority.userinfo);
+        out += '@';
+    }
+    for (std::size_t i = 0; i < authority.host.size(); ++i) {
+        char const c = authority.host[i];
+        if (c == '%' && i + 2 < authority.host.size() && hex_value(authority.host[i + 1]) >= 0 &&
+            hex_value(authority.host[i + 2]) >= 0) {
+            out += '%';
+            out += static_cast<char>(authority.host[i + 1] & ~0x20);
+            out += static_cast<char>(authority.host[i + 2] & ~0x20);
+            i += 2;
+        }
+        else {
+            out += to_lower(c);
+        }
+    }
+    if (!authority.port.empty() && authority.port != default_port(scheme)) {
+        out += ':';
+        out.append(authority.port);
+    }
+
+    // Сначала нормализуется percent-encoding (%2E становится точкой), затем удаляются точечные сегменты
+    thread_local std::string merged;
+    merged.assign(prefix);
+    append_normalized(merged, path);
+    std::size_t const path_start = out.size();
+    remove_dot_segments(merged, out);
+    if (out.size() == path_start || out[path_start] != '/') {
+        out.insert(path_start, 1, '/');
+    }
+
+    if (has_query) {
+        out += '?';
+        append_normalized(out, query);
+    }
+    return true;
+}
+
+// Убирает пробелы по краям и табуляции и переводы строк внутри, как это делают браузеры
+std::string_view clean_reference(std::string_view reference, std::string& buffer) {
+    while (!reference.empty() && static_cast<unsigned char>(reference.front()) <= 0x20) {
+        reference.remove_prefix(1);
+    }
+    while (!reference.empty() && static_cast<unsigned char>(reference.back()) <= 0x20) {
+        reference.remove_suffix(1);
+    }
+    if (reference.find_first_of("\t\n\r") == std::string_view::npos) {
+        return reference;
+    }
+    buffer.clear();
+    for (char c : reference) {
+        if (c != '\t' && c != '\n' && c != '\r') {
+            buffer += c;
+        }
+    }
+    return buffer;
+}
+
+} // namespace
+
+std::string_view default_port(std::string_view scheme) {
+    if (iequals(scheme, "http")) {
+        return "80";
+    }
+    if (iequals(scheme, "https")) {
+        return "443";
+    }
+    return {};
+}
+
+bool parse_url(std::string_view url, UrlParts& parts) {
+    parts = UrlParts{};
+    std::size_t i = 0;
+
+    // scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / "." ) ":"
+    if (!url.empty() && is_alpha(url[0])) {
+        std::size_t j = 1;
+        while (j < url.size() && (is_alpha(url[j]) || is_digit(url[j]) || url[j] == '+' || url[j] == '-' || url[j] == '.')) {
+            ++j;
+        }
+        if (j < url.size() && url[j] == ':') {
+            parts.scheme = url.substr(0, j);
+            i = j + 1;
+        }
+    }
+
+    if (url.substr(i, 2) == "//") {
+        parts.has_authority = true;
+        i += 2;
+        std::size_t const end = std::min(url.find_first_of("/?#", i), url.size());
+        std::string_view authority = url.substr(i, end - i);
+        i = end;
+
+        std::size_t const at = authority.rfind('@');
+        if (at != std::string_view::npos) {
+            parts.userinfo = authority.substr(0, at);
+            authority.remove_prefix(at + 1);
+        }
+        std::string_view port;
+        if (!authority.empty() && authority.front() == '[') {
+            std::size_t const close = authority.find(']');
+            if (close == std::string_view::npos) {
+                return false;
+            }
+            parts.host = authority.substr(0, close + 1);
+            std::string_view const rest = authority.substr(close + 1);
+            if (!rest.empty()) {
+                if (rest.front() != ':') {
+                    return false;
+                }
+                port = rest.substr(1);
+            }
+        }
+        else {
+            std::size_t const colon = authority.rfind(':');
+            parts.host = authority.substr(0, colon);
+            if (colon != std::string_view::npos) {
+                port = authority.substr(colon + 1);
+            }
+        }
+        for (char c : port) {
+            if (!is_digit(c)) {
+                return false;
+            }
+        }
+        parts.port = port;
+    }
+
+    std::size_t const path_end = std::min(url.find_first_of("?#", i), url.size());
+    parts.path = url.substr(i, path_end - i);
+    i = path_end;
+    if (i < url.size() && url[i] == '?') {
+        std::size_t const query_end = std::min(url.find('#', i), url.size());
+        parts.has_query = true;
+        parts.query = url.substr(i + 1, query_end - i - 1);
+        i = query_end;
+    }
+    if (i < url.size() && url[i] == '#') {
+        parts.has_fragment = true;
+        parts.fragment = url.substr(i + 1);
+    }
+    return true;
+}
+
+bool normalize_url(std::string_view url, std::string& out) {
+    thread_local std::string buffer;
+    url = clean_reference(url, buffer);
+    thread_local std::string with_scheme;
+    if (url.find("://") == std::string_view::npos) {
+        with_scheme.assign("http://");
+        with_scheme.append(url);
+        url = with_scheme;
+    }
+
+    UrlParts parts;
+    if (!parse_url(url, parts) || !parts.has_authority || !is_http(parts.scheme)) {
+        return false;
+    }
+    return build(parts.scheme, parts, {}, parts.path, parts.has_query, parts.query, out);
+}
+
+bool resolve_url(const UrlParts& base, std::string_view reference, std::string& out) {
+    thread_local std::string buffer;
+    reference = clean_reference(reference, buffer);
+
+    UrlParts ref;
+    if (!parse_url(reference, ref)) {
+        return false;
+    }
+    // "http:page.html" без authority браузеры считают относительной ссылкой
+    if (!ref.scheme.empty() && !ref.has_authority && iequals(ref.scheme, base.scheme)) {
+        ref.scheme = {};
+    }
+
+    if (!ref.scheme.empty()) {
+        if (!is_http(ref.scheme) || !ref.has_authority) {
+            return false;
+        }
+        return build(ref.scheme, ref, {}, ref.path, ref.has_query, ref.query, out);
+    }
+    if (ref.has_authority) {
+        return build(base.scheme, ref, {}, ref.path, ref.has_query, ref.query, out);
+    }
+    if (ref.path.empty()) {
+        return ref.has_query
+            ? build(base.scheme, base, {}, base.path, true, ref.query, out)
+            : build(base.scheme, base, {}, base.path, base.has_query, base.query, out);
+    }
+    if (ref.path.front() == '/') {
+        return build(base.scheme, base, {}, ref.path, ref.has_query, ref.query, out);
+    }
+
+    // Слияние путей: каталог базового пути и относительный путь ссылки
+    std::string_view directory = "/";
+    std::size_t const slash = base.path.rfind('/');
+    if (slash != std::string_view::npos) {
+        directory = base.path.substr(0, slash + 1);
+    }
+    return build(base.scheme, base, directory, ref.path, ref.has_query, ref.query, out);
+}
@@ -0,0 +1,41 @@
+#ifndef URL_H
+#define URL_H
+
+#include <string>
+#include <string_view>
+
+// Компоненты URL по RFC 3986: представления подстрок исходной строки, без копирования.
+// host у IPv6 включает квадратные скобки.
+struct UrlParts {
+    std::string_view scheme;
+    std::string_view userinfo;
+    std::string_view host;
+    std::string_view port;
+    std::string_view path;
+    std::string_view query;
+    std::string_view fragment;
+    bool has_authority = false;
+    bool has_query = false;
+    bool has_fragment = false;
+};
+
+// Разбирает абсолютный URL или относительную ссылку; false, если разбор невозможен
+// (например, нецифровой порт)
+bool parse_url(std::string_view url, UrlParts& parts);
+
+// Каноническая форма http(s)-URL в out: схема и хост в нижнем регистре, без порта
+// по умолчанию и фрагмента, путь без "." и "..", пустой путь заменен на "/",
+// незарезервированные символы раскодированы, остальные %XX в верхнем регистре,
+// пробелы и байты вне ASCII закодированы. URL без схемы считается http.
+// false, если это не http(s)-URL с хостом.
+bool normalize_url(std::string_view url, std::string& out);
+
+// Разрешает ссылку относительно канонического базового URL (RFC 3986, 5.2)
+// и записывает в out каноническую форму результата. Буфер out переиспользуется.
+// false для ссылок на другие схемы (mailto:, javascript: и т. п.) и некорректных.
+bool resolve_url(const UrlParts& base, std::string_view reference, std::string& out);
+
+// Порт по умолчанию для схемы ("80" или "443"), пустой для остальных
+std::string_view default_port(std::string_view scheme);
+
+#endif // URL_H
@@ -0,0 +1,171 @@
+#include "visited_set.h"
+#include "hash.h"
+#include "url.h"
+
+VisitedSet::VisitedSet(const Config& config)
+    : stripes_(std::make_unique<Stripe[]>(kStripes)),
+    max_entries_(config.visited_max_entries) {
+    if (config.visited_bloom_megabytes > 0) {
+        std::size_t const words = std::size_t(config.visited_bloom_megabytes) * 1024 * 1024 / sizeof(std::uint64_t);
+        bloom_ = std::vector<std::atomic<std::uint64_t>>(words);
+        bloom_bits_ = std::uint64_t(words) * 64;
+    }
+}
+
+std::uint64_t VisitedSet::fingerprint(std::string_view url) {
+    thread_local std::string canonical;
+    if (!normalize_url(url, canonical)) {
+        canonical.assign(url);
+    }
+    std::uint64_t const fp = hash64(canonical);
+    return fp == 0 ? 1 : fp;
+}
+
+bool VisitedSet::Stripe::contains(std::uint64_t fp) const {
+    if (slots.empty()) {
+        return false;
+    }
+    std::size_t const mask = slots.size() - 1;
+    for (std::size_t i = fp & mask; ; i = (i + 1) & mask) {
+        if (slots[i] == fp) {
+            return true;
+        }
+        if (slots[i] == 0) {
+            return false;
+        }
+    }
+}
+
+bool VisitedSet::Stripe::insert(std::uint64_t fp) {
+    if ((count + 1) * 10 > slots.size() * 7) {
+        grow();
+    }
+    std::size_t const mask = slots.size() - 1;
+    for (std::size_t i = fp & mask; ; i = (i + 1) & mask) {
+        if (slots[i] == fp) {
+            return false;
+        }
+        if (slots[i] == 0) {
+            slots[i] = fp;
+            count++;
+            return true;
+        }
+    }
+}
+
+void VisitedSet::Stripe::grow() {
+    std::vector<std::uint64_t> old = std::move(slots);
+    slots.assign(old.empty() ? 1024 : old.size() * 2, 0);
+    std::size_t const mask = slots.size() - 1;
+    for (std::uint64_t fp : old) {
+        if (fp == 0) {
+            continue;
+        }
+        std::size_t i = fp & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = fp;
+    }
+}
+
+bool VisitedSet::bloom_add(std::uint64_t fp) {
+    std::uint64_t const h2 = ((fp >> 33) | (fp << 31)) | 1;
+    bool changed = false;
+    for (int i = 0; i < kBloomHashes; ++i) {
+        std::uint64_t const bit = (fp + i * h2) % bloom_bits_;
+        std::uint64_t const mask = std::uint64_t(1) << (bit & 63);
+        if (!(bloom_[bit >> 6].fetch_or(mask, std::memory_order_relaxed) & mask)) {
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool VisitedSet::bloom_contains(std::uint64_t fp) const {
+    std::uint64_t const h2 = ((fp >> 33) | (fp << 31)) | 1;
+    for (int i = 0; i < kBloomHashes; ++i) {
+        std::uint64_t const bit = (fp + i * h2) % bloom_bits_;
+        if (!(bloom_[bit >> 6].load(std::memory_order_relaxed) & (std::uint64_t(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VisitedSet::insert(std::string_view url) {
+    return insert_fingerprint(fingerprint(url));
+}
+
+bool VisitedSet::insert_fingerprint(std::uint64_t fp) {
+    // Если фильтр Блума установил хотя бы один бит, URL точно новый
+    bool fresh = false;
+    if (!bloom_.empty()) {
+        fresh = bloom_add(fp);
+        if (saturated_) {
+            if (fresh && journal_) {
+                Stripe& stripe = stripes_[fp >> 58];
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                stripe.journal.push_back(fp);
+            }
+            return fresh;
+        }
+    }
+
+    Stripe& stripe = stripes_[fp >> 58];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (!fresh && stripe.contains(fp)) {
+        return false;
+    }
+    // Лимит точного множества действует только вместе с фильтром Блума
+    if (max_entries_ > 0 && entries_ >= max_entries_ && !bloom_.empty()) {
+        saturated_ = true;
+    }
+    else if (stripe.insert(fp)) {
+        entries_++;
+        fresh = true;
+    }
+    else {
+        return false;
+    }
+    if (fresh && journal_) {
+        stripe.journal.push_back(fp);
+    }
+    return fresh;
+}
+
+std::vector<std::uint64_t> VisitedSet::take_journal() {
+    std::vector<std::uint64_t> journal;
+    for (std::size_t i = 0; i < kStripes; ++i) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        journal.insert(journal.end(), stripes_[i].journal.begin(), stripes_[i].journal.end());
+        stripes_[i].journal.clear();
+        stripes_[i].journal.shrink_to_fit();
+    }
+    return journal;
+}
+
+bool VisitedSet::contains(std::string_view url) const {
+    std::uint64_t const fp = fingerprint(url);
+    if (!bloom_.empty()) {
+        if (!bloom_contains(fp)) {
+            return false;
+        }
+        if (saturated_) {
+            return true;
+        }
+    }
+
+    Stripe& stripe = stripes_[fp >> 58];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    return stripe.contains(fp);
+}
+
+std::size_t VisitedSet::memory_bytes() const {
+    std::size_t bytes = bloom_.size() * sizeof(std::uint64_t);
+    for (std::size_t i = 0; i < kStripes; ++i) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        bytes += stripes_[i].slots.size() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
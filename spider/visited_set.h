@@ -0,0 +1,64 @@
+#ifndef VISITED_SET_H
+#define VISITED_SET_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../config/config.h"
+
+// Множество посещенных URL: 64-битные отпечатки нормализованных URL в таблицах
+// с открытой адресацией, разбитых на полосы со своими блокировками.
+// Необязательный фильтр Блума перед ними отсекает новые URL без блокировок
+// и продолжает работать, когда точное множество достигло лимита памяти.
+class VisitedSet {
+public:
+    explicit VisitedSet(const Config& config);
+
+    // Атомарная проверка со вставкой: true, если URL встретился впервые
+    bool insert(std::string_view url);
+    bool insert_fingerprint(std::uint64_t fp);
+    bool contains(std::string_view url) const;
+
+    // Журнал новых отпечатков для контрольных точек границы обхода
+    void enable_journal() { journal_ = true; }
+    std::vector<std::uint64_t> take_journal();
+
+    std::size_t size() const { return entries_; }
+    std::size_t memory_bytes() const;
+
+    // Отпечаток канонической формы URL (normalize_url)
+    static std::uint64_t fingerprint(std::string_view url);
+
+private:
+    static constexpr std::size_t kStripes = 64;
+    static constexpr int kBloomHashes = 7;
+
+    struct alignas(64) Stripe {
+        mutable std::mutex mutex;
+        std::vector<std::uint64_t> slots; // 0 - пустая ячейка
+        std::size_t count = 0;
+        std::vector<std::uint64_t> journal; // Добавленные с последней контрольной точки
+
+        bool contains(std::uint64_t fp) const;
+        bool insert(std::uint64_t fp);
+        void grow();
+    };
+
+    bool bloom_add(std::uint64_t fp);
+    bool bloom_contains(std::uint64_t fp) const;
+
+    std::unique_ptr<Stripe[]> stripes_;
+    std::size_t max_entries_;
+    std::atomic<std::size_t> entries_{ 0 };
+    std::atomic<bool> saturated_{ false };
+    std::atomic<bool> journal_{ false };
+
+    std::vector<std::atomic<std::uint64_t>> bloom_;
+    std::uint64_t bloom_bits_ = 0;
+};
+
+#endif // VISITED_SET_H
@@ -0,0 +1,70 @@
+#ifndef WAKE_SIGNAL_H
+#define WAKE_SIGNAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+// Сигнал для корутин, которым пока нечего делать: вместо опроса по таймеру
+// корутина паркуется до notify() из любого потока. Каждая ждет на своем
+// таймере, созданном на ее strand; notify() отменяет таймеры через post на
+// их исполнитель, поэтому из чужих потоков таймер не трогают.
+//
+// Сигнал не теряется: номер поколения берется до проверки условия, и wait()
+// возвращается сразу, если notify() был после этого. Таймаут - страховка.
+class WakeSignal {
+public:
+    using Timer = boost::asio::steady_timer;
+
+    std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    boost::asio::awaitable<void> wait(std::shared_ptr<Timer> timer, std::uint64_t seen, std::chrono::milliseconds timeout) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (generation_.load(std::memory_order_relaxed) != seen) {
+                co_return;
+            }
+            timer->expires_after(timeout);
+            parked_.push_back(timer);
+        }
+        boost::system::error_code ec;
+        co_await timer->async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+        // По таймауту таймер остается в списке
+        std::lock_guard<std::mutex> lock(mutex_);
+        parked_.erase(std::remove(parked_.begin(), parked_.end(), timer), parked_.end());
+    }
+
+    // Будит всех запаркованных
+    void notify() {
+        std::vector<std::shared_ptr<Timer>> parked;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_.fetch_add(1, std::memory_order_release);
+            if (parked_.empty()) {
+                return;
+            }
+            parked.swap(parked_);
+        }
+        for (auto& timer : parked) {
+            boost::asio::post(timer->get_executor(), [timer]() { timer->cancel(); });
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::atomic<std::uint64_t> generation_{ 0 };
+    std::vector<std::shared_ptr<Timer>> parked_;
+};
+
+#endif // WAKE_SIGNAL_H
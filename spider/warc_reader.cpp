@@ -0,0 +1,217 @@
+#include "warc_reader.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <stdexcept>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <zlib.h>
+
+namespace ipc = boost::interprocess;
+
+namespace {
+
+// Сколько распакованных байт добавляется в буфер за один шаг
+constexpr std::size_t kInflateStep = 256 * 1024;
+constexpr std::size_t kMaxHeaderBytes = 1024 * 1024;
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return (x >= 'A' && x <= 'Z' ? x + ('a' - 'A') : x) == (y >= 'A' && y <= 'Z' ? y + ('a' - 'A') : y);
+        });
+}
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+} // namespace
+
+struct WarcReader::Source {
+    ipc::file_mapping file;
+    ipc::mapped_region region;
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    bool gzip = false;
+    z_stream zs{};
+    bool zs_ready = false;
+    bool finished = false;
+    std::string buffer; // Скользящее окно распакованных данных
+
+    ~Source() {
+        if (zs_ready) {
+            inflateEnd(&zs);
+        }
+    }
+};
+
+WarcReader::WarcReader(const std::string& path) : source_(std::make_unique<Source>()) {
+    Source& source = *source_;
+    source.file = ipc::file_mapping(path.c_str(), ipc::read_only);
+    // Пустой файл отобразить нельзя: в нем просто нет записей
+    if (std::filesystem::file_size(path) > 0) {
+        source.region = ipc::mapped_region(source.file, ipc::read_only);
+        source.region.advise(ipc::mapped_region::advice_sequential);
+        source.data = static_cast<const char*>(source.region.get_address());
+        source.size = source.region.get_size();
+    }
+
+    source.gzip = source.size >= 2 && static_cast<unsigned char>(source.data[0]) == 0x1f &&
+        static_cast<unsigned char>(source.data[1]) == 0x8b;
+    if (source.gzip) {
+        if (inflateInit2(&source.zs, 15 + 16) != Z_OK) {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+        source.zs_ready = true;
+        source.zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(source.data));
+        source.zs.avail_in = 0;
+    }
+}
+
+WarcReader::~WarcReader() = default;
+
+std::size_t WarcReader::size() const {
+    return source_->size;
+}
+
+std::size_t WarcReader::position() const {
+    const Source& source = *source_;
+    if (source.gzip) {
+        return static_cast<std::size_t>(reinterpret_cast<const char*>(source.zs.next_in) - source.data);
+    }
+    return pos_;
+}
+
+std::string_view WarcReader::available() const {
+    const Source& source = *source_;
+    if (source.gzip) {
+        return std::string_view(source.buffer).substr(pos_);
+    }
+    return std::string_view(source.data + pos_, source.size - pos_);
+}
+
+bool WarcReader::fill(std::size_t bytes) {
+    Source& source = *source_;
+    if (!source.gzip) {
+        return source.size - pos_ >= bytes;
+    }
+
+    while (source.buffer.size() - pos_ < bytes) {
+        if (source.finished) {
+            return false;
+        }
+        // Прочитанное начало буфера отбрасывается, когда занимает больше половины
+        if (pos_ > 0 && pos_ * 2 >= source.buffer.size()) {
+            source.buffer.erase(0, pos_);
+            pos_ = 0;
+        }
+
+        z_stream& zs = source.zs;
+        std::size_t const consumed = reinterpret_cast<const char*>(zs.next_in) - source.data;
+        if (zs.avail_in == 0) {
+            zs.avail_in = static_cast<uInt>(std::min<std::size_t>(source.size - consumed, 1u << 30));
+        }
+        std::size_t const used = source.buffer.size();
+        std::size_t const room = std::max(kInflateStep, bytes - (used - pos_));
+        source.buffer.resize(used + room);
+        zs.next_out = reinterpret_cast<Bytef*>(source.buffer.data() + used);
+        zs.avail_out = static_cast<uInt>(room);
+
+        int const ret = inflate(&zs, Z_NO_FLUSH);
+        source.buffer.resize(used + room - zs.avail_out);
+        if (ret == Z_STREAM_END) {
+            // Следующий gzip-член (обычно одна запись WARC на член) или конец файла
+            std::size_t const next = reinterpret_cast<const char*>(zs.next_in) - source.data;
+            if (next >= source.size) {
+                source.finished = true;
+            }
+            else {
+                inflateReset(&zs);
+            }
+        }
+        else if (ret == Z_BUF_ERROR && zs.avail_in == 0) {
+            source.finished = true; // Файл оборван посреди gzip-потока
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("Corrupt WARC gzip stream: ") + (zs.msg ? zs.msg : "inflate error"));
+        }
+    }
+    return true;
+}
+
+bool WarcReader::next(WarcRecord& record) {
+    // Записи разделяются пустыми строками
+    while (true) {
+        if (!fill(1)) {
+            return false;
+        }
+        char const c = available().front();
+        if (c != '\r' && c != '\n') {
+            break;
+        }
+        pos_++;
+    }
+
+    std::size_t header_end = std::string_view::npos;
+    for (std::size_t want = 4096; header_end == std::string_view::npos; want *= 2) {
+        bool const complete = fill(want);
+        std::string_view const data = available();
+        header_end = data.substr(0, std::min(want, data.size())).find("\r\n\r\n");
+        if (header_end == std::string_view::npos && (!complete || want > kMaxHeaderBytes)) {
+            throw std::runtime_error("Truncated or oversized WARC record header");
+        }
+    }
+    std::size_t const header_size = header_end + 4;
+    if (!available().starts_with("WARC/")) {
+        throw std::runtime_error("Not a WARC record at offset " + std::to_string(position()));
+    }
+
+    // Заголовок копируется: при дочитывании блока буфер может сдвинуться
+    header_fields_.assign(available().substr(0, header_size));
+    record = WarcRecord{};
+    std::size_t length = 0;
+    bool has_length = false;
+    std::string_view fields = header_fields_;
+    fields.remove_prefix(fields.find("\r\n") + 2);
+    while (!fields.empty()) {
+        std::size_t const line_end = fields.find("\r\n");
+        std::string_view const line = fields.substr(0, line_end);
+        fields.remove_prefix(line_end == std::string_view::npos ? fields.size() : line_end + 2);
+        std::size_t const colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view const name = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+        if (iequals(name, "Content-Length")) {
+            has_length = std::from_chars(value.data(), value.data() + value.size(), length).ec == std::errc{};
+        }
+        else if (iequals(name, "WARC-Type")) {
+            record.type = value;
+        }
+        else if (iequals(name, "WARC-Target-URI")) {
+            // В черновике WARC 1.1 URI записывался в угловых скобках
+            if (value.size() >= 2 && value.front() == '<' && value.back() == '>') {
+                value = value.substr(1, value.size() - 2);
+            }
+            record.target_uri = value;
+        }
+    }
+    if (!has_length) {
+        throw std::runtime_error("WARC record without Content-Length at offset " + std::to_string(position()));
+    }
+
+    if (!fill(header_size + length)) {
+        throw std::runtime_error("Truncated WARC record block");
+    }
+    record.block = available().substr(header_size, length);
+    pos_ += header_size + length;
+    return true;
+}
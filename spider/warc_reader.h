@@ -0,0 +1,47 @@
+#ifndef WARC_READER_H
+#define WARC_READER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Запись WARC: тип, URI и блок (для response - HTTP-ответ целиком).
+// Представления действительны до следующего вызова WarcReader::next.
+struct WarcRecord {
+    std::string_view type;
+    std::string_view target_uri;
+    std::string_view block;
+};
+
+// Последовательное чтение WARC-файла, отображенного в память. Файлы .warc.gz
+// (отдельный gzip-поток на запись или на весь файл) распаковываются по ходу чтения
+// в скользящий буфер, несжатые читаются прямо из отображения без копирования.
+class WarcReader {
+public:
+    explicit WarcReader(const std::string& path);
+    ~WarcReader();
+
+    WarcReader(const WarcReader&) = delete;
+    WarcReader& operator=(const WarcReader&) = delete;
+
+    // false, когда записи кончились; при повреждении файла бросает std::runtime_error
+    bool next(WarcRecord& record);
+
+    // Сколько байт файла уже прочитано и его размер
+    std::size_t position() const;
+    std::size_t size() const;
+
+private:
+    struct Source;
+
+    // Гарантирует, что после pos_ доступно не меньше bytes байт; false в конце файла
+    bool fill(std::size_t bytes);
+    std::string_view available() const;
+
+    std::unique_ptr<Source> source_;
+    std::size_t pos_ = 0;         // Начало непрочитанных данных в available()
+    std::string header_fields_;   // Поля заголовка текущей записи
+};
+
+#endif // WARC_READER_H